@@ -0,0 +1,118 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Transit cost on a state with many outgoing transitions, triggered with a Zipf
+// distribution whose hottest transitions are the last defined ones, with and
+// without adaptive transition order.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "state_machine.h"
+
+#define BENCH_EDGE_COUNT CSM_TRANSITION_COUNT
+#define BENCH_EVENT_COUNT (1 << 20)
+
+static csm_state_transition_node_t trans_nodes[BENCH_EDGE_COUNT];
+static csm_transition_t events[BENCH_EVENT_COUNT];
+static long rounds = 20;
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// xorshift, deterministic across runs
+static uint64_t next_random(uint64_t *seed) {
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 7;
+  *seed ^= *seed << 17;
+  return *seed;
+}
+
+// rank k is drawn with probability proportional to 1 / (k + 1)^skew, rank 0 maps to the last defined transition
+static void generate_events(double skew) {
+  double cdf[BENCH_EDGE_COUNT];
+  double sum = 0;
+  for (int k = 0; k < BENCH_EDGE_COUNT; k++) {
+    sum += 1.0 / pow(k + 1, skew);
+    cdf[k] = sum;
+  }
+  uint64_t seed = 0x9e3779b97f4a7c15ull;
+  for (int i = 0; i < BENCH_EVENT_COUNT; i++) {
+    double u = (double)(next_random(&seed) >> 11) / (double)(1ull << 53) * sum;
+    int k = 0;
+    while (k < BENCH_EDGE_COUNT - 1 && cdf[k] < u) {
+      k++;
+    }
+    events[i] = BENCH_EDGE_COUNT - 1 - k;
+  }
+}
+
+static double run(csm_bool adaptive) {
+  csm_state_machine_t machine;
+  csm_machine_initialize(&machine, 0);
+  for (int i = 0; i < BENCH_EDGE_COUNT; i++) {
+    csm_machine_define_state_transition(&machine, &trans_nodes[i]);
+  }
+  csm_machine_set_adaptive_transition_order(&machine, adaptive);
+  csm_machine_start(&machine);
+
+  double start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    for (int i = 0; i < BENCH_EVENT_COUNT; i++) {
+      csm_machine_transit(&machine, events[i]);
+    }
+  }
+  double elapsed = now_ns() - start;
+
+  csm_machine_stop(&machine);
+  csm_machine_dealloc(&machine);
+  return elapsed / ((double)rounds * BENCH_EVENT_COUNT);
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    rounds = atol(argv[1]);
+  }
+  // self loops on state 0, so every event is legal
+  for (int i = 0; i < BENCH_EDGE_COUNT; i++) {
+    trans_nodes[i].from_state = 0;
+    trans_nodes[i].transition = i;
+    trans_nodes[i].to_state = 0;
+  }
+
+  const double skews[] = {0.0, 0.8, 1.0, 1.2, 1.5};
+  printf("%d transitions on one state, %d events x %ld rounds\n", BENCH_EDGE_COUNT, BENCH_EVENT_COUNT, rounds);
+  printf("%8s %18s %18s\n", "skew", "ns/transit fixed", "ns/transit mtf");
+  for (int i = 0; i < (int)(sizeof(skews) / sizeof(skews[0])); i++) {
+    generate_events(skews[i]);
+    double fixed = run(CSM_FALSE);
+    double adaptive = run(CSM_TRUE);
+    printf("%8.1f %18.2f %18.2f\n", skews[i], fixed, adaptive);
+  }
+  return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Memory footprint of compact instances sharing a single definition. Built
+// twice: against statemachine with the default 32 bits states, and against
+// statemachine_compact with 8 bits states and transitions.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "compact_machine.h"
+
+#define BENCH_RING_SIZE (8)
+
+typedef enum {
+  BENCH_TRANSITION_NEXT,
+} bench_transition;
+
+static csm_state_transition_node_t trans_nodes[BENCH_RING_SIZE];
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static long max_rss_kb(void) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+int main(int argc, char **argv) {
+  long instance_count = 10000000;
+  if (argc > 1) {
+    instance_count = atol(argv[1]);
+  }
+
+  static csm_state_machine_t machine;
+  csm_machine_initialize(&machine, 0);
+  for (int i = 0; i < BENCH_RING_SIZE; i++) {
+    trans_nodes[i].from_state = i;
+    trans_nodes[i].transition = BENCH_TRANSITION_NEXT;
+    trans_nodes[i].to_state = (i + 1) % BENCH_RING_SIZE;
+    csm_machine_define_state_transition(&machine, &trans_nodes[i]);
+  }
+  csm_compact_definition_t definition;
+  csm_compact_definition_initialize(&definition, &machine);
+
+  long rss_before = max_rss_kb();
+  csm_compact_machine_t *instances = malloc((size_t)instance_count * sizeof(csm_compact_machine_t));
+  if (instances == NULL) {
+    fprintf(stderr, "cannot allocate %ld instances\n", instance_count);
+    return 1;
+  }
+
+  double start = now_ns();
+  for (long i = 0; i < instance_count; i++) {
+    csm_compact_machine_initialize(&definition, &instances[i]);
+    csm_compact_machine_start(&definition, &instances[i]);
+    // spread the instances over the ring
+    for (long t = 0; t < i % BENCH_RING_SIZE; t++) {
+      csm_compact_machine_transit(&definition, &instances[i], BENCH_TRANSITION_NEXT);
+    }
+  }
+  double elapsed = now_ns() - start;
+  long rss_after = max_rss_kb();
+
+  long histogram[BENCH_RING_SIZE] = {0};
+  for (long i = 0; i < instance_count; i++) {
+    histogram[csm_compact_machine_get_current_state(&instances[i])]++;
+  }
+  for (int s = 0; s < BENCH_RING_SIZE; s++) {
+    if (histogram[s] != (instance_count + BENCH_RING_SIZE - 1 - s) / BENCH_RING_SIZE) {
+      fprintf(stderr, "unexpected %ld instances in state %d\n", histogram[s], s);
+      return 1;
+    }
+  }
+
+  printf("state width %d, transition width %d\n", CONFIG_STATE_WIDTH, CONFIG_TRANSITION_WIDTH);
+  printf("%ld compact instances of %zu bytes, %.1f MiB resident, %.2f ns/instance to set up\n", instance_count,
+         sizeof(csm_compact_machine_t), (double)(rss_after - rss_before) / 1024.0, elapsed / (double)instance_count);
+  printf("shared definition: csm_state_machine_t of %zu bytes, %.1f MiB if every instance had its own\n",
+         sizeof(csm_state_machine_t), (double)instance_count * (double)sizeof(csm_state_machine_t) / 1048576.0);
+  free(instances);
+  return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Contention benchmark of csm_machine_transit on a single shared machine.
+// Built twice: against statemachine with a mutex around every transit, and
+// against statemachine_concurrent with the lock free transit.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "state_machine.h"
+
+#define BENCH_RING_SIZE (8)
+#define BENCH_MAX_THREAD_COUNT (16)
+
+typedef enum {
+  BENCH_TRANSITION_NEXT,
+} bench_transition;
+
+static csm_state_machine_t machine;
+static csm_state_transition_node_t trans_nodes[BENCH_RING_SIZE];
+static long transit_per_thread = 1000000;
+
+#if !CONFIG_CONCURRENT_TRANSIT
+static pthread_mutex_t machine_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void *transit_worker(void *arg) {
+  for (long i = 0; i < transit_per_thread; i++) {
+#if CONFIG_CONCURRENT_TRANSIT
+    csm_machine_transit(&machine, BENCH_TRANSITION_NEXT);
+#else
+    pthread_mutex_lock(&machine_lock);
+    csm_machine_transit(&machine, BENCH_TRANSITION_NEXT);
+    pthread_mutex_unlock(&machine_lock);
+#endif
+  }
+  return NULL;
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    transit_per_thread = atol(argv[1]);
+  }
+
+  csm_machine_initialize(&machine, 0);
+  for (int i = 0; i < BENCH_RING_SIZE; i++) {
+    trans_nodes[i].from_state = i;
+    trans_nodes[i].transition = BENCH_TRANSITION_NEXT;
+    trans_nodes[i].to_state = (i + 1) % BENCH_RING_SIZE;
+    csm_machine_define_state_transition(&machine, &trans_nodes[i]);
+  }
+  csm_machine_start(&machine);
+
+  printf("%s, %ld transits per thread\n", CONFIG_CONCURRENT_TRANSIT ? "lock free" : "mutex", transit_per_thread);
+  printf("%8s %14s %14s\n", "threads", "ns/transit", "Mtransit/s");
+  for (int thread_count = 1; thread_count <= BENCH_MAX_THREAD_COUNT; thread_count *= 2) {
+    pthread_t threads[BENCH_MAX_THREAD_COUNT];
+    double start = now_ns();
+    for (int i = 0; i < thread_count; i++) {
+      pthread_create(&threads[i], NULL, transit_worker, NULL);
+    }
+    for (int i = 0; i < thread_count; i++) {
+      pthread_join(threads[i], NULL);
+    }
+    double elapsed = now_ns() - start;
+    double total = (double)transit_per_thread * thread_count;
+    printf("%8d %14.1f %14.2f\n", thread_count, elapsed / total, total / elapsed * 1e3);
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Cost of csm_machine_transit on a ring machine. Built against statemachine
+// with the flight recorder, statemachine_no_flight_recorder without it, and
+// statemachine_flight_recorder_timestamp with cycle counter timestamps, the
+// difference is the recorder overhead. flight_recorder_bench_concurrent and
+// flight_recorder_bench_concurrent_disabled compare the same in concurrent mode,
+// where the budget is not met and the recorder is off by default. Given the ns/transit of the build
+// without recorder as second argument, it fails if the overhead is over budget:
+//
+//   flight_recorder_bench 50000000 $(flight_recorder_bench_disabled | cut -d' ' -f7)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "state_machine.h"
+
+#define BENCH_RING_SIZE (8)
+#define BENCH_OVERHEAD_BUDGET_NS (5.0)
+
+typedef enum {
+  BENCH_TRANSITION_NEXT,
+} bench_transition;
+
+static csm_state_transition_node_t trans_nodes[BENCH_RING_SIZE];
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+  long transit_count = 50000000;
+  if (argc > 1) {
+    transit_count = atol(argv[1]);
+  }
+  double baseline = argc > 2 ? atof(argv[2]) : 0;
+
+  csm_state_machine_t machine;
+  csm_machine_initialize(&machine, 0);
+  for (int i = 0; i < BENCH_RING_SIZE; i++) {
+    trans_nodes[i].from_state = i;
+    trans_nodes[i].transition = BENCH_TRANSITION_NEXT;
+    trans_nodes[i].to_state = (i + 1) % BENCH_RING_SIZE;
+    csm_machine_define_state_transition(&machine, &trans_nodes[i]);
+  }
+  csm_machine_start(&machine);
+
+  double start = now_ns();
+  for (long i = 0; i < transit_count; i++) {
+    csm_machine_transit(&machine, BENCH_TRANSITION_NEXT);
+  }
+  double elapsed = now_ns() - start;
+
+  csm_flight_record_t records[4];
+  int count;
+  csm_machine_flight_records(&machine, records, 4, &count);
+  double per_transit = elapsed / (double)transit_count;
+  printf("flight recorder depth %d, %ld transits, %.2f ns/transit, %d records read back, timestamp %d\n",
+         CSM_FLIGHT_RECORDER_DEPTH, transit_count, per_transit, count, CONFIG_FLIGHT_RECORDER_TIMESTAMP);
+  if (baseline > 0) {
+    double overhead = per_transit - baseline;
+    printf("overhead %.2f ns/transit, budget %.2f ns/transit\n", overhead, BENCH_OVERHEAD_BUDGET_NS);
+    if (overhead > BENCH_OVERHEAD_BUDGET_NS) {
+      return 1;
+    }
+  }
+  return 0;
+}
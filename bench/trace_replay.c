@@ -0,0 +1,489 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Replay a recorded event trace against a pool of machines, closed loop as fast
+// as possible or open loop at a target rate, and report the transit latency
+// percentiles, the throughput and, in closed loop when perf_event_open is
+// available, the cache misses, branch misses and instructions per transit.
+//
+// usage: trace_replay [-r events_per_sec] [-s synthetic_event_count] [-m machine_count]
+//                     [-t transition_count] [-w out.csv] [trace]
+//
+// The trace is either a CSV of `machine_id,transition` lines, lines not starting
+// with a digit are skipped, or a binary file made of the "CSMT" magic followed by
+// pairs of little endian uint32 machine id and transition. Without a trace, a
+// Zipf skewed one is synthesized over -m machines and -t transitions, -w writes
+// it out as CSV.
+//
+// Every machine has the same definition where any transition of the trace is
+// legal on any state, from --t--> (from + t + 1) % CSM_STATE_COUNT, so each
+// event walks the transition list of the current state of its machine. The
+// transitions of each machine are carved from its own arena, next to the
+// others, like machines defined at start up.
+
+#define _GNU_SOURCE
+
+#include <linux/perf_event.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "state_machine.h"
+
+#define REPLAY_BINARY_MAGIC "CSMT"
+#define REPLAY_COUNTER_COUNT (3)
+
+typedef struct {
+  uint32_t machine_id;
+  uint32_t transition;
+} replay_event_t;
+
+typedef struct {
+  replay_event_t *events;
+  long count;
+  long capacity;
+} replay_trace_t;
+
+typedef struct {
+  // group leader first, -1 if not opened
+  int fds[REPLAY_COUNTER_COUNT];
+
+  // the group was not always scheduled on the PMU, the values are extrapolated
+  csm_bool multiplexed;
+} replay_counters_t;
+
+static const char *counter_names[REPLAY_COUNTER_COUNT] = {"cache misses", "branch misses", "instructions"};
+
+static const uint64_t counter_configs[REPLAY_COUNTER_COUNT] = {
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+};
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// xorshift, deterministic across runs
+static uint64_t next_random(uint64_t *seed) {
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 7;
+  *seed ^= *seed << 17;
+  return *seed;
+}
+
+static int append_event(replay_trace_t *trace, uint32_t machine_id, uint32_t transition) {
+  if (trace->count == trace->capacity) {
+    long capacity = trace->capacity == 0 ? 4096 : trace->capacity * 2;
+    replay_event_t *events = realloc(trace->events, (size_t)capacity * sizeof(replay_event_t));
+    if (events == NULL) {
+      return -1;
+    }
+    trace->events = events;
+    trace->capacity = capacity;
+  }
+  trace->events[trace->count].machine_id = machine_id;
+  trace->events[trace->count].transition = transition;
+  trace->count++;
+  return 0;
+}
+
+static uint32_t read_le32(const unsigned char *bytes) {
+  return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static int load_trace(const char *path, replay_trace_t *trace) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    perror(path);
+    return -1;
+  }
+  int ret = 0;
+  char magic[sizeof(REPLAY_BINARY_MAGIC) - 1];
+  if (fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, REPLAY_BINARY_MAGIC, sizeof(magic)) == 0) {
+    unsigned char pair[8];
+    while (ret == 0 && fread(pair, 1, sizeof(pair), file) == sizeof(pair)) {
+      ret = append_event(trace, read_le32(pair), read_le32(pair + 4));
+    }
+  } else {
+    rewind(file);
+    char line[256];
+    unsigned long machine_id;
+    unsigned long transition;
+    while (ret == 0 && fgets(line, sizeof(line), file) != NULL) {
+      if (line[0] < '0' || line[0] > '9') {
+        continue;
+      }
+      if (sscanf(line, "%lu , %lu", &machine_id, &transition) != 2) {
+        fprintf(stderr, "%s: cannot parse '%s'\n", path, line);
+        ret = -1;
+        break;
+      }
+      ret = append_event(trace, (uint32_t)machine_id, (uint32_t)transition);
+    }
+  }
+  fclose(file);
+  return ret;
+}
+
+// rank k is drawn with probability proportional to 1 / (k + 1)^skew
+static double *zipf_cdf(long count, double skew) {
+  double *cdf = malloc((size_t)count * sizeof(double));
+  double sum = 0;
+  for (long k = 0; cdf != NULL && k < count; k++) {
+    sum += 1.0 / pow((double)(k + 1), skew);
+    cdf[k] = sum;
+  }
+  return cdf;
+}
+
+static long zipf_draw(const double *cdf, long count, uint64_t *seed) {
+  double u = (double)(next_random(seed) >> 11) / (double)(1ull << 53) * cdf[count - 1];
+  long low = 0;
+  long high = count - 1;
+  while (low < high) {
+    long mid = (low + high) / 2;
+    if (cdf[mid] < u) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+static int synthesize_trace(replay_trace_t *trace, long event_count, long machine_count, long transition_count) {
+  double *machine_cdf = zipf_cdf(machine_count, 1.1);
+  double *transition_cdf = zipf_cdf(transition_count, 1.5);
+  uint32_t *machine_ids = malloc((size_t)machine_count * sizeof(uint32_t));
+  int ret = machine_cdf == NULL || transition_cdf == NULL || machine_ids == NULL ? -1 : 0;
+  uint64_t seed = 0x9e3779b97f4a7c15ull;
+  // scatter the hot machines over the pool instead of packing them at the start
+  for (long i = 0; ret == 0 && i < machine_count; i++) {
+    long j = (long)(next_random(&seed) % (uint64_t)(i + 1));
+    machine_ids[i] = machine_ids[j];
+    machine_ids[j] = (uint32_t)i;
+  }
+  for (long i = 0; ret == 0 && i < event_count; i++) {
+    uint32_t machine_id = machine_ids[zipf_draw(machine_cdf, machine_count, &seed)];
+    uint32_t transition = (uint32_t)zipf_draw(transition_cdf, transition_count, &seed);
+    ret = append_event(trace, machine_id, transition);
+  }
+  free(machine_cdf);
+  free(transition_cdf);
+  free(machine_ids);
+  return ret;
+}
+
+static void close_counters(replay_counters_t *counters);
+
+static int write_trace(const char *path, const replay_trace_t *trace) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    perror(path);
+    return -1;
+  }
+  fprintf(file, "machine_id,transition\n");
+  for (long i = 0; i < trace->count; i++) {
+    fprintf(file, "%u,%u\n", trace->events[i].machine_id, trace->events[i].transition);
+  }
+  return fclose(file);
+}
+
+static int open_counters(replay_counters_t *counters) {
+  for (int i = 0; i < REPLAY_COUNTER_COUNT; i++) {
+    counters->fds[i] = -1;
+  }
+  for (int i = 0; i < REPLAY_COUNTER_COUNT; i++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = counter_configs[i];
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.disabled = i == 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    counters->fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, counters->fds[0], 0);
+    if (counters->fds[i] < 0) {
+      perror("perf_event_open");
+      close_counters(counters);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void close_counters(replay_counters_t *counters) {
+  for (int i = 0; i < REPLAY_COUNTER_COUNT; i++) {
+    if (counters->fds[i] >= 0) {
+      close(counters->fds[i]);
+      counters->fds[i] = -1;
+    }
+  }
+}
+
+static void start_counters(replay_counters_t *counters) {
+  if (counters->fds[0] >= 0) {
+    ioctl(counters->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(counters->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+}
+
+static int stop_counters(replay_counters_t *counters, double *values) {
+  if (counters->fds[0] < 0) {
+    return -1;
+  }
+  ioctl(counters->fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  // layout of the group read: number of counters, time enabled, time running, then the counter values
+  uint64_t group[3 + REPLAY_COUNTER_COUNT];
+  ssize_t size = read(counters->fds[0], group, sizeof(group));
+  if (size != (ssize_t)sizeof(group) || group[0] != REPLAY_COUNTER_COUNT || group[2] == 0) {
+    return -1;
+  }
+  // the group was multiplexed with other events when it ran only part of the time it was enabled, extrapolate
+  double scale = (double)group[1] / (double)group[2];
+  if (group[2] < group[1]) {
+    counters->multiplexed = CSM_TRUE;
+  }
+  for (int i = 0; i < REPLAY_COUNTER_COUNT; i++) {
+    values[i] = (double)group[3 + i] * scale;
+  }
+  return 0;
+}
+
+static int compare_latency(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+static uint32_t percentile(const uint32_t *sorted, long count, double p) {
+  long index = (long)ceil(p * (double)count) - 1;
+  return sorted[index < 0 ? 0 : index];
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [-r events_per_sec] [-s synthetic_event_count] [-m machine_count] [-t transition_count]\n"
+          "       [-w out.csv] [trace]\n",
+          name);
+}
+
+int main(int argc, char **argv) {
+  double rate = 0;
+  long synthetic_count = 1000000;
+  long machine_count = 0;
+  long transition_count = 8;
+  const char *output_path = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "r:s:m:t:w:h")) != -1) {
+    switch (opt) {
+      case 'r':
+        rate = atof(optarg);
+        break;
+      case 's':
+        synthetic_count = atol(optarg);
+        break;
+      case 'm':
+        machine_count = atol(optarg);
+        break;
+      case 't':
+        transition_count = atol(optarg);
+        break;
+      case 'w':
+        output_path = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+
+  replay_trace_t trace = {NULL, 0, 0};
+  if (optind < argc) {
+    if (load_trace(argv[optind], &trace) != 0) {
+      return 1;
+    }
+  } else {
+    if (machine_count <= 0) {
+      machine_count = 4096;
+    }
+    if (synthetic_count <= 0 || transition_count <= 0 || transition_count > CSM_TRANSITION_COUNT ||
+        synthesize_trace(&trace, synthetic_count, machine_count, transition_count) != 0) {
+      usage(argv[0]);
+      return 1;
+    }
+    if (output_path != NULL && write_trace(output_path, &trace) != 0) {
+      return 1;
+    }
+  }
+  if (trace.count == 0) {
+    fprintf(stderr, "empty trace\n");
+    return 1;
+  }
+
+  // size the pool and collect the transitions used by the trace
+  csm_bool used[CSM_TRANSITION_COUNT] = {CSM_FALSE};
+  for (long i = 0; i < trace.count; i++) {
+    if (trace.events[i].transition >= CSM_TRANSITION_COUNT) {
+      fprintf(stderr, "event %ld: transition %u out of range [0, %d)\n", i, trace.events[i].transition,
+              CSM_TRANSITION_COUNT);
+      return 1;
+    }
+    used[trace.events[i].transition] = CSM_TRUE;
+    if ((long)trace.events[i].machine_id >= machine_count) {
+      machine_count = (long)trace.events[i].machine_id + 1;
+    }
+  }
+  int used_count = 0;
+  for (int t = 0; t < CSM_TRANSITION_COUNT; t++) {
+    used_count += used[t] == CSM_TRUE;
+  }
+
+  // every defined transition takes a list node and a transition node from the arena, each aligned on max_align_t
+  size_t slot = sizeof(csm_linked_list_node_t) + sizeof(csm_state_transition_node_t) + _Alignof(max_align_t);
+  size_t arena_size = (size_t)CSM_STATE_COUNT * (size_t)used_count * slot;
+  csm_state_machine_t *machines = malloc((size_t)machine_count * sizeof(csm_state_machine_t));
+  csm_arena_t *arenas = malloc((size_t)machine_count * sizeof(csm_arena_t));
+  csm_allocator_t *allocators = malloc((size_t)machine_count * sizeof(csm_allocator_t));
+  unsigned char *storage = malloc((size_t)machine_count * arena_size);
+  uint32_t *latencies = malloc((size_t)trace.count * sizeof(uint32_t));
+  if (machines == NULL || arenas == NULL || allocators == NULL || storage == NULL || latencies == NULL) {
+    fprintf(stderr, "cannot allocate %ld machines\n", machine_count);
+    return 1;
+  }
+  for (long m = 0; m < machine_count; m++) {
+    csm_arena_initialize(&arenas[m], storage + (size_t)m * arena_size, arena_size);
+    csm_arena_allocator(&arenas[m], &allocators[m]);
+    csm_machine_initialize_with_allocator(&machines[m], 0, &allocators[m]);
+    for (int s = 0; s < CSM_STATE_COUNT; s++) {
+      for (int t = 0; t < CSM_TRANSITION_COUNT; t++) {
+        if (used[t] != CSM_TRUE) {
+          continue;
+        }
+        csm_state_transition_node_t node = {
+            .from_state = s,
+            .transition = t,
+            .to_state = (s + t + 1) % CSM_STATE_COUNT,
+        };
+        if (csm_machine_define_state_transition(&machines[m], &node) != CSM_MACHINE_ERR_OK) {
+          fprintf(stderr, "machine %ld: cannot define transition %d on state %d\n", m, t, s);
+          return 1;
+        }
+      }
+    }
+    csm_machine_start(&machines[m]);
+  }
+
+  // in open loop the counters would mostly measure the wait for the next event, only count in closed loop
+  replay_counters_t counters = {.fds = {-1, -1, -1}, .multiplexed = CSM_FALSE};
+  int counters_read = rate > 0 ? -1 : open_counters(&counters);
+
+  // the replay loop without the transits, its cost is reported as the timer overhead and its counts are
+  // subtracted from the replay counts
+  double calibration_values[REPLAY_COUNTER_COUNT];
+  volatile uint32_t sink = 0;
+  start_counters(&counters);
+  for (long i = 0; i < trace.count; i++) {
+    uint64_t begin = now_ns();
+    sink += trace.events[i].machine_id;
+    uint64_t end = now_ns();
+    latencies[i] = end - begin > UINT32_MAX ? UINT32_MAX : (uint32_t)(end - begin);
+  }
+  if (counters_read == 0) {
+    counters_read = stop_counters(&counters, calibration_values);
+  }
+  qsort(latencies, (size_t)trace.count, sizeof(uint32_t), compare_latency);
+  uint32_t timer_overhead = percentile(latencies, trace.count, 0.5);
+
+  long rejected = 0;
+  double interval = rate > 0 ? 1e9 / rate : 0;
+  double replay_values[REPLAY_COUNTER_COUNT];
+  start_counters(&counters);
+  uint64_t start = now_ns();
+  for (long i = 0; i < trace.count; i++) {
+    uint64_t begin = now_ns();
+    if (rate > 0) {
+      // open loop, the latency counts from when the event was due, so falling behind shows up as queueing
+      uint64_t due = start + (uint64_t)((double)i * interval);
+      while (begin < due) {
+        begin = now_ns();
+      }
+      begin = due;
+    }
+    replay_event_t *event = &trace.events[i];
+    rejected += csm_machine_transit(&machines[event->machine_id], (csm_transition_t)event->transition) !=
+                CSM_MACHINE_ERR_OK;
+    uint64_t end = now_ns();
+    latencies[i] = end - begin > UINT32_MAX ? UINT32_MAX : (uint32_t)(end - begin);
+  }
+  uint64_t elapsed = now_ns() - start;
+  if (counters_read == 0) {
+    counters_read = stop_counters(&counters, replay_values);
+  }
+  close_counters(&counters);
+
+  qsort(latencies, (size_t)trace.count, sizeof(uint32_t), compare_latency);
+  printf("%ld events over %ld machines, %d transitions, %s", trace.count, machine_count, used_count,
+         rate > 0 ? "open loop" : "closed loop");
+  if (rate > 0) {
+    printf(" at %.0f events/s", rate);
+  }
+  printf(", %ld rejected\n", rejected);
+  printf("throughput %.0f events/s\n", (double)trace.count * 1e9 / (double)elapsed);
+  printf("latency p50 %u ns, p99 %u ns, p999 %u ns, max %u ns (timer overhead %u ns)\n",
+         percentile(latencies, trace.count, 0.5), percentile(latencies, trace.count, 0.99),
+         percentile(latencies, trace.count, 0.999), latencies[trace.count - 1], timer_overhead);
+  if (counters_read == 0) {
+    // user space only, the calibration run is subtracted so the clock reads are not counted
+    printf("per transit:");
+    for (int i = 0; i < REPLAY_COUNTER_COUNT; i++) {
+      printf(" %.2f %s%s", (replay_values[i] - calibration_values[i]) / (double)trace.count, counter_names[i],
+             i + 1 < REPLAY_COUNTER_COUNT ? "," : "\n");
+    }
+    if (counters.multiplexed == CSM_TRUE) {
+      printf("hardware counters were multiplexed, values are scaled estimates\n");
+    }
+  } else if (rate > 0) {
+    printf("hardware counters only collected in closed loop, timing only\n");
+  } else {
+    printf("hardware counters unavailable, timing only\n");
+  }
+
+  free(latencies);
+  free(storage);
+  free(allocators);
+  free(arenas);
+  free(machines);
+  free(trace.events);
+  return 0;
+}
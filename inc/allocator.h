@@ -0,0 +1,89 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "types.h"
+
+typedef struct {
+  // allocate `size` bytes, return CSM_NULL if no space left
+  void *(*alloc)(void *context, size_t size);
+
+  // release everything allocated so far at once
+  void (*release)(void *context);
+
+  // allocator context passed to the functions above
+  void *context;
+} csm_allocator_t;
+
+typedef struct {
+  // backing memory
+  unsigned char *buffer;
+
+  // size of backing memory
+  size_t capacity;
+
+  // offset of the next allocation
+  size_t offset;
+} csm_arena_t;
+
+/**
+ * @brief Initialize a bump arena over a buffer owned by the caller
+ * @param arena pointer to the arena
+ * @param buffer backing memory
+ * @param capacity size of backing memory
+ */
+void csm_arena_initialize(csm_arena_t *arena, void *buffer, size_t capacity);
+
+/**
+ * @brief Allocate from the arena, allocations are contiguous and aligned for any type
+ * @param arena pointer to the arena
+ * @param size size to allocate
+ * @return allocated memory, or CSM_NULL if no space left
+ */
+void *csm_arena_alloc(csm_arena_t *arena, size_t size);
+
+/**
+ * @brief Release every allocation of the arena in O(1)
+ * @param arena pointer to the arena
+ */
+void csm_arena_release(csm_arena_t *arena);
+
+/**
+ * @brief Get an allocator backed by the arena
+ * @param arena pointer to the arena
+ * @param allocator pointer to the allocator to fill
+ */
+void csm_arena_allocator(csm_arena_t *arena, csm_allocator_t *allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALLOCATOR_H_ */
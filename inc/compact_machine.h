@@ -0,0 +1,156 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef COMPACT_MACHINE_H_
+#define COMPACT_MACHINE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "conf.h"
+#include "state_machine.h"
+
+typedef struct {
+  // current state and machine status, packed with CSM_MACHINE_WORD_PACK
+  csm_machine_word_t word;
+} csm_compact_machine_t;
+
+typedef struct csm_compact_definition_t csm_compact_definition_t;
+
+typedef void (*csm_compact_on_state_changed)(const csm_compact_definition_t *definition,
+                                             csm_compact_machine_t *instance, csm_state_t prev_state,
+                                             csm_state_t new_state);
+
+typedef void (*csm_compact_on_machine_status_changed)(const csm_compact_definition_t *definition,
+                                                      csm_compact_machine_t *instance,
+                                                      csm_machine_status prev_status, csm_machine_status new_status);
+
+typedef struct csm_compact_definition_t {
+  // machine holding the initial state and the transitions shared by all the instances
+  csm_state_machine_t *machine;
+
+  // state change callback of all the instances
+  csm_compact_on_state_changed on_state_changed;
+
+  // machine internal status change callback of all the instances
+  csm_compact_on_machine_status_changed on_machine_status_changed;
+} csm_compact_definition_t;
+
+/**
+ * @brief Initialize a definition shared by compact instances. The transitions are looked up in the given machine,
+ *        which must not be started nor deallocated while the instances are in use.
+ * @param definition pointer to the definition
+ * @param machine pointer to the state machine holding the initial state and the transitions
+ * @return CSM_MACHINE_ERR_OK if operation success
+ */
+csm_machine_err_t csm_compact_definition_initialize(csm_compact_definition_t *definition,
+                                                    csm_state_machine_t *machine);
+
+/**
+ * @brief Register state change callback of all the instances
+ * @param definition pointer to the definition
+ * @param on_state_changed state change callback
+ * @return CSM_MACHINE_ERR_OK if operation success
+ */
+csm_machine_err_t csm_compact_register_on_state_changed(csm_compact_definition_t *definition,
+                                                        csm_compact_on_state_changed on_state_changed);
+
+/**
+ * @brief Register machine internal status change callback of all the instances
+ * @param definition pointer to the definition
+ * @param on_machine_status_changed status change callback
+ * @return CSM_MACHINE_ERR_OK if operation success
+ */
+csm_machine_err_t csm_compact_register_on_machine_status_changed(
+    csm_compact_definition_t *definition, csm_compact_on_machine_status_changed on_machine_status_changed);
+
+/**
+ * @brief Initialize a compact instance in 'new' status at the initial state of the definition
+ * @param definition pointer to the definition
+ * @param instance pointer to the instance
+ * @return CSM_MACHINE_ERR_OK if operation success
+ */
+csm_machine_err_t csm_compact_machine_initialize(const csm_compact_definition_t *definition,
+                                                 csm_compact_machine_t *instance);
+
+/**
+ * @brief Start a compact instance
+ * @param definition pointer to the definition
+ * @param instance pointer to the instance
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if instance not in 'new' status
+ */
+csm_machine_err_t csm_compact_machine_start(const csm_compact_definition_t *definition,
+                                            csm_compact_machine_t *instance);
+
+/**
+ * @brief Trigger a state transition on a compact instance
+ * @param definition pointer to the definition
+ * @param instance pointer to the instance
+ * @param transition the transition to trigger
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if instance not in 'started' status
+ *         CSM_MACHINE_ERR_ILLEGAL_TRANSITION: if transition not defined on current state
+ */
+csm_machine_err_t csm_compact_machine_transit(const csm_compact_definition_t *definition,
+                                              csm_compact_machine_t *instance, csm_transition_t transition);
+
+/**
+ * @brief Stop a compact instance
+ * @param definition pointer to the definition
+ * @param instance pointer to the instance
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if instance not in 'started' status
+ */
+csm_machine_err_t csm_compact_machine_stop(const csm_compact_definition_t *definition,
+                                           csm_compact_machine_t *instance);
+
+/**
+ * @brief Reset a compact instance to the initial state
+ * @param definition pointer to the definition
+ * @param instance pointer to the instance
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if instance not in 'started' or stopped status
+ */
+csm_machine_err_t csm_compact_machine_reset(const csm_compact_definition_t *definition,
+                                            csm_compact_machine_t *instance);
+
+/**
+ * @brief Get the current state of a compact instance
+ * @param instance pointer to the instance
+ * @return current state
+ */
+csm_state_t csm_compact_machine_get_current_state(const csm_compact_machine_t *instance);
+
+/**
+ * @brief Get the internal status of a compact instance
+ * @param instance pointer to the instance
+ * @return machine status
+ */
+csm_machine_status csm_compact_machine_get_status(const csm_compact_machine_t *instance);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMPACT_MACHINE_H_ */
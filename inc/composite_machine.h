@@ -0,0 +1,114 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef COMPOSITE_MACHINE_H_
+#define COMPOSITE_MACHINE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "conf.h"
+#include "state_machine.h"
+
+#define CSM_COMPOSITE_REGION_COUNT CONFIG_COMPOSITE_REGION_COUNT
+
+// one bit per region, packed into 32 bits words
+typedef uint32_t csm_region_mask_t;
+
+#define CSM_REGION_MASK_BITS (32)
+
+#define CSM_REGION_MASK_WORDS ((CSM_COMPOSITE_REGION_COUNT + CSM_REGION_MASK_BITS - 1) / CSM_REGION_MASK_BITS)
+
+// CSM_STATE_COUNT marks an undefined transition in the combined lookup
+#if CONFIG_STATE_WIDTH < 32 && CSM_STATE_COUNT >= (1 << CONFIG_STATE_WIDTH)
+#error "CONFIG_STATE_COUNT leaves no spare state value in CONFIG_STATE_WIDTH for the composite machine"
+#endif
+
+// The combined lookup takes CSM_TRANSITION_COUNT * CSM_COMPOSITE_REGION_COUNT * CSM_STATE_COUNT entries whatever the
+// count of regions added, a byte each when CSM_STATE_COUNT < 256, 20 KiB with the default configuration. Allocate
+// composite machines statically or on the heap rather than on the stack, or lower CONFIG_COMPOSITE_REGION_COUNT.
+typedef struct {
+  // orthogonal regions, each one is a standalone state machine
+  csm_state_machine_t *regions[CSM_COMPOSITE_REGION_COUNT];
+
+  // count of regions added
+  int region_count;
+
+  // regions having the transition defined on any of their states
+  csm_region_mask_t transition_regions[CSM_TRANSITION_COUNT][CSM_REGION_MASK_WORDS];
+
+  // combined lookup, state of each region after a transition indexed by its current state,
+  // CSM_STATE_COUNT if the transition is not defined on that state
+  csm_next_state_t next_states[CSM_TRANSITION_COUNT][CSM_COMPOSITE_REGION_COUNT][CSM_STATE_COUNT];
+
+  // step the regions with multiple threads, only effective when built with OpenMP
+  csm_bool parallel;
+} csm_composite_machine_t;
+
+/**
+ * @brief Initialize a composite machine without any region
+ * @param composite pointer to the composite machine
+ * @return CSM_MACHINE_ERR_OK if operation success
+ */
+csm_machine_err_t csm_composite_initialize(csm_composite_machine_t *composite);
+
+/**
+ * @brief Add a region to the composite machine. The region transitions must be defined before it is added,
+ *        they are flattened into the combined lookup of the composite machine.
+ * @param composite pointer to the composite machine
+ * @param region pointer to the state machine of the region
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_FAILED: if no region slot left
+ */
+csm_machine_err_t csm_composite_add_region(csm_composite_machine_t *composite, csm_state_machine_t *region);
+
+/**
+ * @brief Enable or disable stepping the regions in parallel, the regions are split across the threads.
+ *        When enabled, the region callbacks may be invoked from multiple threads.
+ * @param composite pointer to the composite machine
+ * @param parallel CSM_TRUE to enable
+ * @return CSM_MACHINE_ERR_OK if operation success
+ */
+csm_machine_err_t csm_composite_set_parallel(csm_composite_machine_t *composite, csm_bool parallel);
+
+/**
+ * @brief Dispatch a transition to every region. Each region status is checked once and its next state is read
+ *        from the combined lookup. Regions not in 'started' status or without the transition defined on their
+ *        current state are left untouched, without on_illegal_transition being invoked.
+ * @param composite pointer to the composite machine
+ * @param transition the transition to trigger
+ * @param changed receives the bitmask of regions that transited, must hold CSM_REGION_MASK_WORDS words
+ * @return CSM_MACHINE_ERR_OK: at least one region transited
+ *         CSM_MACHINE_ERR_ILLEGAL_TRANSITION: no region transited
+ *         CSM_MACHINE_ERR_FAILED: if transition out of range
+ */
+csm_machine_err_t csm_composite_transit(csm_composite_machine_t *composite, csm_transition_t transition,
+                                        csm_region_mask_t *changed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMPOSITE_MACHINE_H_ */
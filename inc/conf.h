@@ -34,4 +34,47 @@
 #define CONFIG_STATE_COUNT (20)
 #endif
 
+// The width in bits of a state, 8, 16 or 32, states must be in range [0, 2^width)
+#ifndef CONFIG_STATE_WIDTH
+#define CONFIG_STATE_WIDTH (32)
+#endif
+
+// The width in bits of a transition, 8, 16 or 32
+#ifndef CONFIG_TRANSITION_WIDTH
+#define CONFIG_TRANSITION_WIDTH (32)
+#endif
+
+// The total transition count, transitions must be in range [0, CONFIG_TRANSITION_COUNT)
+#ifndef CONFIG_TRANSITION_COUNT
+#define CONFIG_TRANSITION_COUNT (32)
+#endif
+
+// Pack current state and machine status into one atomic word so that machines
+// can be driven from multiple threads without lock
+#ifndef CONFIG_CONCURRENT_TRANSIT
+#define CONFIG_CONCURRENT_TRANSIT (0)
+#endif
+
+// The count of recent transits kept per machine for post-mortem analysis,
+// must be a power of 2, 0 to disable the flight recorder. Off by default with
+// CONFIG_CONCURRENT_TRANSIT, where each record takes two more atomic read-modify-writes
+#ifndef CONFIG_FLIGHT_RECORDER_DEPTH
+#if CONFIG_CONCURRENT_TRANSIT
+#define CONFIG_FLIGHT_RECORDER_DEPTH (0)
+#else
+#define CONFIG_FLIGHT_RECORDER_DEPTH (16)
+#endif
+#endif
+
+// Stamp the flight records with the CPU cycle counter, off by default as reading the counter
+// can cost tens of nanoseconds per transit, e.g. when it traps in a virtual machine
+#ifndef CONFIG_FLIGHT_RECORDER_TIMESTAMP
+#define CONFIG_FLIGHT_RECORDER_TIMESTAMP (0)
+#endif
+
+// The max region count of a composite machine
+#ifndef CONFIG_COMPOSITE_REGION_COUNT
+#define CONFIG_COMPOSITE_REGION_COUNT (32)
+#endif
+
 #endif /* CSM_CONF_H_ */
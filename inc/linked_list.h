@@ -61,6 +61,18 @@ typedef struct {
 csm_linked_list_err_t csm_linked_list_find_node(csm_linked_list_t *list, void **data, csm_comparator predicate,
                                                 void *predicate_data);
 
+/**
+ * @brief Find the node with given predicate, and move it to the head of the list so that
+ *        frequently found nodes are checked first
+ * @param list linked list
+ * @param data Pointer to receive the data
+ * @param predicate Predicate to find the node
+ * @param predicate_data Predicate context data (similar to closure context)
+ * @return CSM_ERR_OK if found, otherwise CSM_ERR_FAILED is returned
+ */
+csm_linked_list_err_t csm_linked_list_find_node_move_to_front(csm_linked_list_t *list, void **data,
+                                                              csm_comparator predicate, void *predicate_data);
+
 /**
  * @brief Add a node to the end of the linked list
  * @param list linked list
@@ -69,6 +81,23 @@ csm_linked_list_err_t csm_linked_list_find_node(csm_linked_list_t *list, void **
  */
 csm_linked_list_err_t csm_linked_list_append_node(csm_linked_list_t *list, void *data);
 
+/**
+ * @brief Add a node allocated by the caller to the end of the linked list, the node pool is not used
+ * @param list linked list
+ * @param new_node node storage owned by the caller
+ * @param data data to add to the linked list
+ * @return CSM_ERR_OK if add success
+ */
+csm_linked_list_err_t csm_linked_list_append_allocated_node(csm_linked_list_t *list, csm_linked_list_node_t *new_node,
+                                                            void *data);
+
+/**
+ * @brief Remove all the nodes from the linked list, and return them to the node pool
+ * @param list linked list
+ * @return CSM_ERR_OK if success, CSM_ERR_LINKED_LIST_ILLEGAL_STATE if some node was not taken from the pool
+ */
+csm_linked_list_err_t csm_linked_list_clear(csm_linked_list_t *list);
+
 /**
  * @brief Remove a node from the linked list with given predicate
  * @param list linked list
@@ -0,0 +1,205 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef SHM_STORE_H_
+#define SHM_STORE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "state_machine.h"
+
+#define CSM_SHM_STORE_MAGIC (0x43534d53u)
+
+#define CSM_SHM_STORE_VERSION (1)
+
+// marks an undefined transition in the next state table
+#define CSM_SHM_STORE_NO_TRANSITION (-1)
+
+/*
+ * Segment layout, every reference is an offset from the segment base so the segment
+ * can be mapped at a different address in every process:
+ *
+ *   csm_shm_store_header_t
+ *   int32_t next_state[state_count][transition_count]
+ *   uint64_t machine_word[machine_count]
+ *
+ * A machine word packs the current state (bits 0-31), the machine status (bits 32-39) and
+ * a sequence number (bits 40-63) bumped on every change. Words are only ever modified with
+ * a single compare and swap, so a process crashing at any point leaves every machine either
+ * before or after a transition, and no lock is left held.
+ */
+typedef struct {
+  // CSM_SHM_STORE_MAGIC once the segment is formatted, written last
+  uint32_t magic;
+
+  // CSM_SHM_STORE_VERSION
+  uint32_t version;
+
+  // count of states in the next state table
+  uint32_t state_count;
+
+  // count of transitions in the next state table
+  uint32_t transition_count;
+
+  // count of machines in the store
+  uint32_t machine_count;
+
+  // initial state of every machine
+  int32_t init_state;
+
+  // offset of the next state table
+  uint64_t table_offset;
+
+  // offset of the machine words
+  uint64_t machine_offset;
+
+  // total segment size
+  uint64_t size;
+} csm_shm_store_header_t;
+
+typedef struct {
+  // segment mapped in the current process
+  csm_shm_store_header_t *header;
+
+  // mapped length if the segment was mapped by csm_shm_store_open, otherwise 0
+  size_t mapped_size;
+} csm_shm_store_t;
+
+/**
+ * @brief Get the segment size needed by a store
+ * @param machine_count count of machines in the store
+ * @return size in bytes
+ */
+size_t csm_shm_store_size(int machine_count);
+
+/**
+ * @brief Format a store in a memory region, every machine is put in 'new' status with the definition initial state.
+ *        Callbacks of the definition are not copied since they are only valid in the current process.
+ * @param base base address of the region, 8 bytes aligned
+ * @param size size of the region, at least csm_shm_store_size(machine_count)
+ * @param definition state machine with the transitions defined
+ * @param machine_count count of machines in the store
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_FAILED: if region too small, initial state out of range or atomics not lock free
+ */
+csm_machine_err_t csm_shm_store_format(void *base, size_t size, csm_state_machine_t *definition, int machine_count);
+
+/**
+ * @brief Attach to a formatted store
+ * @param store pointer to the store handle
+ * @param base base address of the region in the current process
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_FAILED: if the region is not a formatted store, or its layout or states are out of range
+ */
+csm_machine_err_t csm_shm_store_attach(csm_shm_store_t *store, void *base);
+
+/**
+ * @brief Map a POSIX shared memory object, creating and formatting it if definition is given.
+ *        The store is only published once formatted, so if the creator dies between creating the object and
+ *        formatting it, the object is left unformatted: opening it fails, and so does creating it again since
+ *        it already exists. Once no creator is running, recover with csm_shm_store_unlink and create it again.
+ * @param store pointer to the store handle
+ * @param name name of the shared memory object, e.g. "/csm_store"
+ * @param definition state machine with the transitions defined, CSM_NULL to open an existing store
+ * @param machine_count count of machines when creating, ignored when opening
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_FAILED: if the object can not be created, mapped or attached
+ */
+csm_machine_err_t csm_shm_store_open(csm_shm_store_t *store, const char *name, csm_state_machine_t *definition,
+                                     int machine_count);
+
+/**
+ * @brief Unmap a store mapped by csm_shm_store_open
+ * @param store pointer to the store handle
+ * @return CSM_MACHINE_ERR_OK if operation success
+ */
+csm_machine_err_t csm_shm_store_close(csm_shm_store_t *store);
+
+/**
+ * @brief Remove a POSIX shared memory object
+ * @param name name of the shared memory object
+ * @return CSM_MACHINE_ERR_OK if operation success, otherwise CSM_MACHINE_ERR_FAILED is returned
+ */
+csm_machine_err_t csm_shm_store_unlink(const char *name);
+
+/**
+ * @brief Start a machine of the store
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if machine not in 'new' status
+ *         CSM_MACHINE_ERR_FAILED: if machine id out of range
+ */
+csm_machine_err_t csm_shm_machine_start(csm_shm_store_t *store, int machine_id);
+
+/**
+ * @brief Trigger a state transition on a machine of the store, safe to call from any process
+ * @param store pointer to the store handle
+ * @param machine_id index of the machine
+ * @param transition the transition to trigger
+ * @param prev_state receives the state the transition was applied to, may be CSM_NULL
+ * @param new_state receives the state after transition, may be CSM_NULL
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if machine not in 'started' status
+ *         CSM_MACHINE_ERR_ILLEGAL_TRANSITION: if transition not defined on current state
+ *         CSM_MACHINE_ERR_FAILED: if machine id or transition out of range, or the machine word is corrupted
+ */
+csm_machine_err_t csm_shm_machine_transit(csm_shm_store_t *store, int machine_id, csm_transition_t transition,
+                                          csm_state_t *prev_state, csm_state_t *new_state);
+
+/**
+ * @brief Stop a machine of the store
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if machine not in 'started' status
+ *         CSM_MACHINE_ERR_FAILED: if machine id out of range
+ */
+csm_machine_err_t csm_shm_machine_stop(csm_shm_store_t *store, int machine_id);
+
+/**
+ * @brief Reset a machine of the store to the initial state and 'started' status
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if machine not in 'started' or 'stopped' status
+ *         CSM_MACHINE_ERR_FAILED: if machine id out of range
+ */
+csm_machine_err_t csm_shm_machine_reset(csm_shm_store_t *store, int machine_id);
+
+/**
+ * @brief Read a consistent snapshot of a machine of the store
+ * @param store pointer to the store handle
+ * @param machine_id index of the machine
+ * @param state receives the current state, may be CSM_NULL
+ * @param status receives the machine status, may be CSM_NULL
+ * @param sequence receives the change sequence number, may be CSM_NULL
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_FAILED: if machine id out of range
+ */
+csm_machine_err_t csm_shm_machine_load(csm_shm_store_t *store, int machine_id, csm_state_t *state,
+                                       csm_machine_status *status, uint32_t *sequence);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHM_STORE_H_ */
@@ -27,12 +27,33 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
+
+#include "allocator.h"
 #include "conf.h"
+#if CONFIG_CONCURRENT_TRANSIT
+#include <stdatomic.h>
+#endif
 #include "linked_list.h"
 #include "types.h"
 
 #define CSM_STATE_COUNT CONFIG_STATE_COUNT
 
+#define CSM_TRANSITION_COUNT CONFIG_TRANSITION_COUNT
+
+#define CSM_FLIGHT_RECORDER_DEPTH CONFIG_FLIGHT_RECORDER_DEPTH
+
+#if (CSM_FLIGHT_RECORDER_DEPTH & (CSM_FLIGHT_RECORDER_DEPTH - 1)) != 0
+#error "CONFIG_FLIGHT_RECORDER_DEPTH must be a power of 2"
+#endif
+
+// one bit per transition, packed into 32 bits words
+typedef uint32_t csm_transition_mask_t;
+
+#define CSM_TRANSITION_MASK_BITS (32)
+
+#define CSM_TRANSITION_MASK_WORDS ((CSM_TRANSITION_COUNT + CSM_TRANSITION_MASK_BITS - 1) / CSM_TRANSITION_MASK_BITS)
+
 typedef enum {
   CSM_MACHINE_STATUS_NEW,
   CSM_MACHINE_STATUS_STARTED,
@@ -40,9 +61,56 @@ typedef enum {
   CSM_MACHINE_STATUS_DESTROYED,
 } csm_machine_status;
 
+#if CONFIG_TRANSITION_WIDTH == 8
+typedef uint8_t csm_transition_t;
+#elif CONFIG_TRANSITION_WIDTH == 16
+typedef uint16_t csm_transition_t;
+#elif CONFIG_TRANSITION_WIDTH == 32
 typedef int csm_transition_t;
+#else
+#error "CONFIG_TRANSITION_WIDTH must be 8, 16 or 32"
+#endif
 
+#if CONFIG_STATE_WIDTH == 8
+typedef uint8_t csm_state_t;
+// current state in the low 8 bits, machine status in the high 8 bits
+typedef uint16_t csm_machine_word_t;
+#elif CONFIG_STATE_WIDTH == 16
+typedef uint16_t csm_state_t;
+// current state in the low 16 bits, machine status in the high 16 bits
+typedef uint32_t csm_machine_word_t;
+#elif CONFIG_STATE_WIDTH == 32
 typedef int csm_state_t;
+// current state in the low 32 bits, machine status in the high 32 bits
+typedef uint64_t csm_machine_word_t;
+#else
+#error "CONFIG_STATE_WIDTH must be 8, 16 or 32"
+#endif
+
+#if CONFIG_STATE_WIDTH < 32 && CSM_STATE_COUNT > (1 << CONFIG_STATE_WIDTH)
+#error "CONFIG_STATE_COUNT does not fit in CONFIG_STATE_WIDTH"
+#endif
+
+#if CONFIG_TRANSITION_WIDTH < 32 && CSM_TRANSITION_COUNT > (1 << CONFIG_TRANSITION_WIDTH)
+#error "CONFIG_TRANSITION_COUNT does not fit in CONFIG_TRANSITION_WIDTH"
+#endif
+
+// entry of a next state table indexed by state, CSM_STATE_COUNT marks an undefined transition,
+// a single byte when every state and the marker fit in it
+#if CSM_STATE_COUNT < 256
+typedef uint8_t csm_next_state_t;
+#else
+typedef csm_state_t csm_next_state_t;
+#endif
+
+#define CSM_MACHINE_WORD_STATE_MASK ((csm_machine_word_t)(((csm_machine_word_t)1 << CONFIG_STATE_WIDTH) - 1))
+
+#define CSM_MACHINE_WORD_PACK(state, status) \
+  ((csm_machine_word_t)(((csm_machine_word_t)(status) << CONFIG_STATE_WIDTH) | ((state) & CSM_MACHINE_WORD_STATE_MASK)))
+
+#define CSM_MACHINE_WORD_STATE(word) ((csm_state_t)((word) & CSM_MACHINE_WORD_STATE_MASK))
+
+#define CSM_MACHINE_WORD_STATUS(word) ((csm_machine_status)((word) >> CONFIG_STATE_WIDTH))
 
 typedef enum {
   CSM_MACHINE_ERR_OK,
@@ -62,6 +130,37 @@ typedef struct {
   csm_state_t to_state;
 } csm_state_transition_node_t;
 
+typedef struct {
+  // cycle counter when the transit happened, 0 if the platform has no cycle counter or
+  // CONFIG_FLIGHT_RECORDER_TIMESTAMP is 0
+  uint64_t timestamp;
+
+  // state the transition was triggered on
+  csm_state_t prev_state;
+
+  // transition triggered
+  csm_transition_t transition;
+
+  // state after the transit, same as prev_state if the transition was rejected
+  csm_state_t new_state;
+
+  // CSM_MACHINE_ERR_OK or CSM_MACHINE_ERR_ILLEGAL_TRANSITION
+  csm_machine_err_t result;
+} csm_flight_record_t;
+
+#if CONFIG_CONCURRENT_TRANSIT
+// flight record written by several threads, fields are relaxed atomics guarded by the sequence,
+// 2 * index + 1 while the record of transit `index` is being written, 2 * index + 2 once complete
+typedef struct {
+  _Atomic uint32_t sequence;
+  _Atomic uint64_t timestamp;
+  _Atomic csm_state_t prev_state;
+  _Atomic csm_transition_t transition;
+  _Atomic csm_state_t new_state;
+  _Atomic csm_machine_err_t result;
+} csm_flight_slot_t;
+#endif
+
 typedef struct csm_state_machine_t csm_state_machine_t;
 
 typedef void (*csm_machine_on_state_changed)(csm_state_machine_t *machine, csm_state_t prev_state,
@@ -70,24 +169,62 @@ typedef void (*csm_machine_on_state_changed)(csm_state_machine_t *machine, csm_s
 typedef void (*csm_machine_on_machine_status_changed)(csm_state_machine_t *machine, csm_machine_status prev_status,
                                                       csm_machine_status new_status);
 
+typedef void (*csm_machine_on_illegal_transition)(csm_state_machine_t *machine, csm_state_t state,
+                                                  csm_transition_t transition);
+
 typedef struct csm_state_machine_t {
+#if CONFIG_CONCURRENT_TRANSIT
+  // current state and machine status, only updated with compare and swap
+  _Atomic csm_machine_word_t machine_word;
+#else
   // machine status
   csm_machine_status internal_machine_status;
+#endif
 
   // initial state
   csm_state_t init_state;
 
+#if !CONFIG_CONCURRENT_TRANSIT
   // current state
   csm_state_t current_state;
+#endif
 
   // state transition linked list
   csm_linked_list_t state_transition_linked_list[CSM_STATE_COUNT];
 
+  // per state bitset of the transitions defined on that state
+  csm_transition_mask_t state_transition_mask[CSM_STATE_COUNT][CSM_TRANSITION_MASK_WORDS];
+
   // machine state change callback
   csm_machine_on_state_changed on_state_changed;
 
   // machine internal status change callback
   csm_machine_on_machine_status_changed on_machine_status_changed;
+
+  // illegal transition callback
+  csm_machine_on_illegal_transition on_illegal_transition;
+
+  // allocator of the transition storage, CSM_NULL to use the global node pool
+  csm_allocator_t *allocator;
+
+  // move the transitions found by csm_machine_transit to the head of their state list
+  csm_bool adaptive_transition_order;
+
+#if CSM_FLIGHT_RECORDER_DEPTH > 0
+  // ring buffer of the recent transits
+#if CONFIG_CONCURRENT_TRANSIT
+  csm_flight_slot_t flight_records[CSM_FLIGHT_RECORDER_DEPTH];
+#else
+  csm_flight_record_t flight_records[CSM_FLIGHT_RECORDER_DEPTH];
+#endif
+
+  // count of transits recorded since initialized, the next record goes to count % depth
+#if CONFIG_CONCURRENT_TRANSIT
+  _Atomic uint32_t flight_record_count;
+#else
+  uint32_t flight_record_count;
+#endif
+#endif
 } csm_state_machine_t;
 
 /**
@@ -98,6 +235,17 @@ typedef struct csm_state_machine_t {
  */
 csm_machine_err_t csm_machine_initialize(csm_state_machine_t *machine, csm_state_t init_state);
 
+/**
+ * @brief Initialize a state machine which takes its transition storage from an allocator.
+ *        The allocator is released as a whole when the machine is deallocated, so it must not be shared.
+ * @param machine pointer to the state machine
+ * @param init_state initial state
+ * @param allocator allocator of the transition storage, CSM_NULL to use the global node pool
+ * @return CSM_MACHINE_ERR_OK if operation success, otherwise CSM_MACHINE_ERR_FAILED is returned
+ */
+csm_machine_err_t csm_machine_initialize_with_allocator(csm_state_machine_t *machine, csm_state_t init_state,
+                                                        csm_allocator_t *allocator);
+
 /**
  * @brief Register state change callback
  * @param machine pointer to the state machine
@@ -116,18 +264,39 @@ csm_machine_err_t csm_machine_register_on_state_changed(csm_state_machine_t *mac
 csm_machine_err_t csm_machine_register_on_machine_status_changed(
     csm_state_machine_t *machine, csm_machine_on_machine_status_changed on_machine_status_changed);
 
+/**
+ * @brief Reorder the transitions of each state by usage, the transition just triggered is moved to the head of
+ *        its state list so the hottest transitions are found first. When several transitions share the same state
+ *        and transition, the one used is still the first defined.
+ * @param machine pointer to the state machine
+ * @param enable CSM_TRUE to enable
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_FAILED: with CONFIG_CONCURRENT_TRANSIT, where the lists must not be modified
+ */
+csm_machine_err_t csm_machine_set_adaptive_transition_order(csm_state_machine_t *machine, csm_bool enable);
+
+/**
+ * @brief Register illegal transition callback, e.g. to dump the flight records
+ * @param machine pointer to the state machine
+ * @param on_illegal_transition callback invoked when csm_machine_transit rejects a transition
+ * @return CSM_MACHINE_ERR_OK if operation success, otherwise CSM_MACHINE_ERR_FAILED is returned
+ */
+csm_machine_err_t csm_machine_register_on_illegal_transition(csm_state_machine_t *machine,
+                                                             csm_machine_on_illegal_transition on_illegal_transition);
+
 /**
  * @brief Define state change transition
  * @param machine pointer to the state machine
  * @param transition_node transition action
  * @return CSM_MACHINE_ERR_OK: operation success
  *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if machine not in 'new' status
+ *         CSM_MACHINE_ERR_FAILED: if state or transition out of range, or no node left in the pool
  */
 csm_machine_err_t csm_machine_define_state_transition(csm_state_machine_t *machine,
                                                       csm_state_transition_node_t *transition_node);
 
 /**
- * @brief Deallocate the machine
+ * @brief Deallocate the machine, and release its transition storage
  * @param machine pointer to the state machine
  * @return CSM_MACHINE_ERR_OK: operation success
  *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if machine not in 'stopped' status
@@ -143,7 +312,9 @@ csm_machine_err_t csm_machine_dealloc(csm_state_machine_t *machine);
 csm_machine_err_t csm_machine_start(csm_state_machine_t *machine);
 
 /**
- * @brief Trigger a state transition
+ * @brief Trigger a state transition.
+ *        With CONFIG_CONCURRENT_TRANSIT, it can be called from multiple threads at the same time, the state change
+ *        callback is invoked after the transition is applied, with the exact state pair the transition was applied to.
  * @param machine pointer to the state machine
  * @param transition the transition to trigger
  * @return CSM_MACHINE_ERR_OK: operation success
@@ -167,6 +338,93 @@ csm_machine_err_t csm_machine_stop(csm_state_machine_t *machine);
  */
 csm_machine_err_t csm_machine_reset(csm_state_machine_t *machine);
 
+/**
+ * @brief Get the current state of a machine
+ * @param machine pointer to the state machine
+ * @return current state
+ */
+csm_state_t csm_machine_get_current_state(csm_state_machine_t *machine);
+
+/**
+ * @brief Get the internal status of a machine
+ * @param machine pointer to the state machine
+ * @return machine status
+ */
+csm_machine_status csm_machine_get_status(csm_state_machine_t *machine);
+
+/**
+ * @brief Look up the state a transition leads to from a given state, without changing the machine
+ * @param machine pointer to the state machine holding the transitions
+ * @param state state the transition is triggered on
+ * @param transition the transition to look up
+ * @param to_state receives the state after transition
+ * @return CSM_MACHINE_ERR_OK: transition defined on the state
+ *         CSM_MACHINE_ERR_ILLEGAL_TRANSITION: transition not defined on the state
+ *         CSM_MACHINE_ERR_FAILED: if state out of range
+ */
+csm_machine_err_t csm_machine_find_transition(csm_state_machine_t *machine, csm_state_t state,
+                                              csm_transition_t transition, csm_state_t *to_state);
+
+/**
+ * @brief Trigger a state transition whose target was looked up by the caller, e.g. from a table flattened out of
+ *        the machine transitions. The machine status is checked once and the transition lists are not walked.
+ *        An undefined transition is left to the caller, neither recorded nor reported to on_illegal_transition.
+ * @param machine pointer to the state machine
+ * @param transition the transition to trigger
+ * @param next_states state after transition indexed by the current state, CSM_STATE_COUNT if undefined
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if machine not in 'started' status
+ *         CSM_MACHINE_ERR_ILLEGAL_TRANSITION: if transition not defined on current state
+ */
+csm_machine_err_t csm_machine_transit_with_next_states(csm_state_machine_t *machine, csm_transition_t transition,
+                                                       const csm_next_state_t *next_states);
+
+/**
+ * @brief Copy the most recent transits recorded by the flight recorder, oldest first.
+ *        With CONFIG_CONCURRENT_TRANSIT, records being written or overwritten while copying are skipped, as well
+ *        as records dropped because another thread was writing the same slot.
+ * @param machine pointer to the state machine
+ * @param records array to receive the records
+ * @param capacity capacity of the records array
+ * @param count receives the number of records copied, at most CSM_FLIGHT_RECORDER_DEPTH
+ * @return CSM_MACHINE_ERR_OK if operation success
+ */
+csm_machine_err_t csm_machine_flight_records(csm_state_machine_t *machine, csm_flight_record_t *records, int capacity,
+                                             int *count);
+
+/**
+ * @brief Check whether a transition is legal in the current state, without changing the machine
+ * @param machine pointer to the state machine
+ * @param transition the transition to check
+ * @return CSM_TRUE if machine in 'started' status and the transition is defined on current state,
+ *         otherwise CSM_FALSE is returned
+ */
+csm_bool csm_machine_can_transit(csm_state_machine_t *machine, csm_transition_t transition);
+
+/**
+ * @brief Check a transition against many machines at once
+ * @param machines array of pointers to the state machines
+ * @param machine_count count of machines
+ * @param transition the transition to check
+ * @param results receives csm_machine_can_transit result of each machine, must hold machine_count items
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_FAILED: if transition out of range
+ */
+csm_machine_err_t csm_machine_can_transit_bulk(csm_state_machine_t *const *machines, int machine_count,
+                                               csm_transition_t transition, csm_bool *results);
+
+/**
+ * @brief List the transitions legal in the current state, in ascending order
+ * @param machine pointer to the state machine
+ * @param transitions array to receive the transitions
+ * @param capacity capacity of the transitions array
+ * @param count receives the number of legal transitions, may be greater than capacity
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if machine not in 'started' status
+ */
+csm_machine_err_t csm_machine_available_transitions(csm_state_machine_t *machine, csm_transition_t *transitions,
+                                                    int capacity, int *count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,96 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef STATE_MACHINE_PATH_H_
+#define STATE_MACHINE_PATH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "state_machine.h"
+
+// one bit per state, packed into 32 bits words
+typedef uint32_t csm_state_mask_t;
+
+#define CSM_STATE_MASK_BITS (32)
+
+#define CSM_STATE_MASK_WORDS ((CSM_STATE_COUNT + CSM_STATE_MASK_BITS - 1) / CSM_STATE_MASK_BITS)
+
+typedef struct {
+  // transition to trigger for the first step of the shortest path
+  csm_transition_t transition;
+
+  // state reached after the first step
+  csm_state_t state;
+} csm_path_hop_t;
+
+typedef struct {
+  // reachable[from] has bit `to` set if `to` can be reached from `from`, every state reaches itself
+  csm_state_mask_t reachable[CSM_STATE_COUNT][CSM_STATE_MASK_WORDS];
+
+  // next_hop[from][to] is the first step of the shortest path, valid only if `to` is reachable and differs from `from`
+  csm_path_hop_t next_hop[CSM_STATE_COUNT][CSM_STATE_COUNT];
+} csm_path_index_t;
+
+/**
+ * @brief Build the reachability and shortest path index from the transitions defined on a machine.
+ *        The index can be shared by all the machines with the same transitions.
+ * @param index pointer to the index to build
+ * @param machine pointer to the state machine
+ * @return CSM_MACHINE_ERR_OK if operation success
+ */
+csm_machine_err_t csm_path_index_build(csm_path_index_t *index, csm_state_machine_t *machine);
+
+/**
+ * @brief Check whether a state can be reached from another one
+ * @param index pointer to the index
+ * @param from source state
+ * @param to target state
+ * @return CSM_TRUE if reachable, otherwise CSM_FALSE is returned
+ */
+csm_bool csm_path_index_is_reachable(const csm_path_index_t *index, csm_state_t from, csm_state_t to);
+
+/**
+ * @brief Get the shortest transition sequence driving the machine from its current state to the target state
+ * @param machine pointer to the state machine
+ * @param index index built from the machine transitions
+ * @param target target state
+ * @param transitions array to receive the transitions
+ * @param capacity capacity of the transitions array
+ * @param length receives the path length, may be greater than capacity
+ * @return CSM_MACHINE_ERR_OK: operation success
+ *         CSM_MACHINE_ERR_ILLEGAL_STATUS: if machine not in 'started' status
+ *         CSM_MACHINE_ERR_ILLEGAL_TRANSITION: if target can not be reached
+ *         CSM_MACHINE_ERR_FAILED: if target out of range
+ */
+csm_machine_err_t csm_machine_path_to(csm_state_machine_t *machine, const csm_path_index_t *index,
+                                      csm_state_t target, csm_transition_t *transitions, int capacity,
+                                      int *length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STATE_MACHINE_PATH_H_ */
@@ -0,0 +1,59 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "allocator.h"
+
+#include <stdint.h>
+
+#define ARENA_ALIGNMENT (_Alignof(max_align_t))
+
+static void *arena_alloc(void *context, size_t size);
+static void arena_release(void *context);
+
+void csm_arena_initialize(csm_arena_t *arena, void *buffer, size_t capacity) {
+  arena->buffer = (unsigned char *)buffer;
+  arena->capacity = capacity;
+  arena->offset = 0;
+}
+
+void *csm_arena_alloc(csm_arena_t *arena, size_t size) {
+  uintptr_t base = (uintptr_t)arena->buffer;
+  size_t offset = (size_t)(((base + arena->offset + ARENA_ALIGNMENT - 1) & ~(uintptr_t)(ARENA_ALIGNMENT - 1)) - base);
+  if (offset > arena->capacity || size > arena->capacity - offset) {
+    return CSM_NULL;
+  }
+  arena->offset = offset + size;
+  return arena->buffer + offset;
+}
+
+void csm_arena_release(csm_arena_t *arena) { arena->offset = 0; }
+
+void csm_arena_allocator(csm_arena_t *arena, csm_allocator_t *allocator) {
+  allocator->alloc = arena_alloc;
+  allocator->release = arena_release;
+  allocator->context = arena;
+}
+
+static void *arena_alloc(void *context, size_t size) { return csm_arena_alloc((csm_arena_t *)context, size); }
+
+static void arena_release(void *context) { csm_arena_release((csm_arena_t *)context); }
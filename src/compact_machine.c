@@ -0,0 +1,125 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "compact_machine.h"
+
+static void set_status(const csm_compact_definition_t *definition, csm_compact_machine_t *instance,
+                       csm_machine_status to_status);
+
+csm_machine_err_t csm_compact_definition_initialize(csm_compact_definition_t *definition,
+                                                    csm_state_machine_t *machine) {
+  definition->machine = machine;
+  definition->on_state_changed = CSM_NULL;
+  definition->on_machine_status_changed = CSM_NULL;
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_compact_register_on_state_changed(csm_compact_definition_t *definition,
+                                                        csm_compact_on_state_changed on_state_changed) {
+  definition->on_state_changed = on_state_changed;
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_compact_register_on_machine_status_changed(
+    csm_compact_definition_t *definition, csm_compact_on_machine_status_changed on_machine_status_changed) {
+  definition->on_machine_status_changed = on_machine_status_changed;
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_compact_machine_initialize(const csm_compact_definition_t *definition,
+                                                 csm_compact_machine_t *instance) {
+  instance->word = CSM_MACHINE_WORD_PACK(definition->machine->init_state, CSM_MACHINE_STATUS_NEW);
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_compact_machine_start(const csm_compact_definition_t *definition,
+                                            csm_compact_machine_t *instance) {
+  if (CSM_MACHINE_WORD_STATUS(instance->word) != CSM_MACHINE_STATUS_NEW) {
+    return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+  }
+  set_status(definition, instance, CSM_MACHINE_STATUS_STARTED);
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_compact_machine_transit(const csm_compact_definition_t *definition,
+                                              csm_compact_machine_t *instance, csm_transition_t transition) {
+  if (CSM_MACHINE_WORD_STATUS(instance->word) != CSM_MACHINE_STATUS_STARTED) {
+    return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+  }
+  csm_state_t current_state = CSM_MACHINE_WORD_STATE(instance->word);
+  csm_state_t to_state;
+  if (csm_machine_find_transition(definition->machine, current_state, transition, &to_state) != CSM_MACHINE_ERR_OK) {
+    return CSM_MACHINE_ERR_ILLEGAL_TRANSITION;
+  }
+
+  if (definition->on_state_changed != CSM_NULL) {
+    // trigger state change callback
+    definition->on_state_changed(definition, instance, current_state, to_state);
+  }
+
+  instance->word = CSM_MACHINE_WORD_PACK(to_state, CSM_MACHINE_STATUS_STARTED);
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_compact_machine_stop(const csm_compact_definition_t *definition,
+                                           csm_compact_machine_t *instance) {
+  if (CSM_MACHINE_WORD_STATUS(instance->word) != CSM_MACHINE_STATUS_STARTED) {
+    return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+  }
+  set_status(definition, instance, CSM_MACHINE_STATUS_STOPPED);
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_compact_machine_reset(const csm_compact_definition_t *definition,
+                                            csm_compact_machine_t *instance) {
+  csm_machine_status status = CSM_MACHINE_WORD_STATUS(instance->word);
+  if (status != CSM_MACHINE_STATUS_STARTED && status != CSM_MACHINE_STATUS_STOPPED) {
+    return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+  }
+  if (definition->on_machine_status_changed != CSM_NULL) {
+    definition->on_machine_status_changed(definition, instance, status, CSM_MACHINE_STATUS_STARTED);
+  }
+  if (definition->on_state_changed != CSM_NULL) {
+    definition->on_state_changed(definition, instance, CSM_MACHINE_WORD_STATE(instance->word),
+                                 definition->machine->init_state);
+  }
+  instance->word = CSM_MACHINE_WORD_PACK(definition->machine->init_state, CSM_MACHINE_STATUS_STARTED);
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_state_t csm_compact_machine_get_current_state(const csm_compact_machine_t *instance) {
+  return CSM_MACHINE_WORD_STATE(instance->word);
+}
+
+csm_machine_status csm_compact_machine_get_status(const csm_compact_machine_t *instance) {
+  return CSM_MACHINE_WORD_STATUS(instance->word);
+}
+
+static void set_status(const csm_compact_definition_t *definition, csm_compact_machine_t *instance,
+                       csm_machine_status to_status) {
+  csm_machine_status prev_status = CSM_MACHINE_WORD_STATUS(instance->word);
+  if (definition->on_machine_status_changed != CSM_NULL) {
+    definition->on_machine_status_changed(definition, instance, prev_status, to_status);
+  }
+  instance->word = CSM_MACHINE_WORD_PACK(CSM_MACHINE_WORD_STATE(instance->word), to_status);
+}
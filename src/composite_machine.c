@@ -0,0 +1,148 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "composite_machine.h"
+
+static csm_region_mask_t step_regions(csm_composite_machine_t *composite, csm_transition_t transition, int word);
+#ifdef _OPENMP
+static csm_region_mask_t step_regions_parallel(csm_composite_machine_t *composite, csm_transition_t transition,
+                                               csm_region_mask_t *changed);
+#endif
+
+csm_machine_err_t csm_composite_initialize(csm_composite_machine_t *composite) {
+  composite->region_count = 0;
+  for (int i = 0; i < CSM_COMPOSITE_REGION_COUNT; i++) {
+    composite->regions[i] = CSM_NULL;
+  }
+  for (int t = 0; t < CSM_TRANSITION_COUNT; t++) {
+    for (int w = 0; w < CSM_REGION_MASK_WORDS; w++) {
+      composite->transition_regions[t][w] = 0;
+    }
+    for (int i = 0; i < CSM_COMPOSITE_REGION_COUNT; i++) {
+      for (int s = 0; s < CSM_STATE_COUNT; s++) {
+        composite->next_states[t][i][s] = CSM_STATE_COUNT;
+      }
+    }
+  }
+  composite->parallel = CSM_FALSE;
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_composite_add_region(csm_composite_machine_t *composite, csm_state_machine_t *region) {
+  if (composite->region_count >= CSM_COMPOSITE_REGION_COUNT) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  int index = composite->region_count++;
+  composite->regions[index] = region;
+
+  // flatten the transitions of all the region states into the combined lookup
+  csm_region_mask_t bit = (csm_region_mask_t)1 << (index % CSM_REGION_MASK_BITS);
+  for (int t = 0; t < CSM_TRANSITION_COUNT; t++) {
+    for (int s = 0; s < CSM_STATE_COUNT; s++) {
+      csm_state_t to_state;
+      if (csm_machine_find_transition(region, s, t, &to_state) == CSM_MACHINE_ERR_OK) {
+        composite->next_states[t][index][s] = to_state;
+        composite->transition_regions[t][index / CSM_REGION_MASK_BITS] |= bit;
+      }
+    }
+  }
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_composite_set_parallel(csm_composite_machine_t *composite, csm_bool parallel) {
+  composite->parallel = parallel;
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_composite_transit(csm_composite_machine_t *composite, csm_transition_t transition,
+                                        csm_region_mask_t *changed) {
+  if (transition < 0 || transition >= CSM_TRANSITION_COUNT) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+
+  csm_region_mask_t any = 0;
+  int words = (composite->region_count + CSM_REGION_MASK_BITS - 1) / CSM_REGION_MASK_BITS;
+#ifdef _OPENMP
+  if (composite->parallel == CSM_TRUE && composite->region_count > 1) {
+    any = step_regions_parallel(composite, transition, changed);
+  } else
+#endif
+  {
+    for (int w = 0; w < words; w++) {
+      changed[w] = step_regions(composite, transition, w);
+      any |= changed[w];
+    }
+  }
+  for (int w = words; w < CSM_REGION_MASK_WORDS; w++) {
+    changed[w] = 0;
+  }
+  return any != 0 ? CSM_MACHINE_ERR_OK : CSM_MACHINE_ERR_ILLEGAL_TRANSITION;
+}
+
+static csm_region_mask_t step_regions(csm_composite_machine_t *composite, csm_transition_t transition, int word) {
+  csm_region_mask_t candidates = composite->transition_regions[transition][word];
+  csm_region_mask_t changed = 0;
+  for (int j = 0; candidates != 0; j++, candidates >>= 1) {
+    if ((candidates & 1) == 0) {
+      continue;
+    }
+    int index = word * CSM_REGION_MASK_BITS + j;
+    if (csm_machine_transit_with_next_states(composite->regions[index], transition,
+                                             composite->next_states[transition][index]) == CSM_MACHINE_ERR_OK) {
+      changed |= (csm_region_mask_t)1 << j;
+    }
+  }
+  return changed;
+}
+
+#ifdef _OPENMP
+static csm_region_mask_t step_regions_parallel(csm_composite_machine_t *composite, csm_transition_t transition,
+                                               csm_region_mask_t *changed) {
+  // one slot per region, so no synchronization is needed, packed into the mask afterwards
+  csm_bool stepped[CSM_COMPOSITE_REGION_COUNT];
+  int region_count = composite->region_count;
+#pragma omp parallel for
+  for (int i = 0; i < region_count; i++) {
+    csm_region_mask_t candidates = composite->transition_regions[transition][i / CSM_REGION_MASK_BITS];
+    stepped[i] = CSM_FALSE;
+    if (((candidates >> (i % CSM_REGION_MASK_BITS)) & 1) != 0 &&
+        csm_machine_transit_with_next_states(composite->regions[i], transition,
+                                             composite->next_states[transition][i]) == CSM_MACHINE_ERR_OK) {
+      stepped[i] = CSM_TRUE;
+    }
+  }
+
+  csm_region_mask_t any = 0;
+  int words = (region_count + CSM_REGION_MASK_BITS - 1) / CSM_REGION_MASK_BITS;
+  for (int w = 0; w < words; w++) {
+    changed[w] = 0;
+  }
+  for (int i = 0; i < region_count; i++) {
+    if (stepped[i] == CSM_TRUE) {
+      changed[i / CSM_REGION_MASK_BITS] |= (csm_region_mask_t)1 << (i % CSM_REGION_MASK_BITS);
+      any = 1;
+    }
+  }
+  return any;
+}
+#endif
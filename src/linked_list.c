@@ -32,7 +32,7 @@ typedef enum {
 #define NODE_POOL_SIZE CONFIG_NODE_POOL_SIZE
 
 static csm_linked_list_node_t node_pool[NODE_POOL_SIZE];
-static unsigned char node_pool_state[NODE_POOL_SIZE / 8] = {POOL_STATE_FREE};
+static unsigned char node_pool_state[(NODE_POOL_SIZE + 7) / 8] = {POOL_STATE_FREE};
 
 static csm_linked_list_err_t malloc_node(csm_linked_list_node_t **node_ptr);
 static csm_linked_list_err_t free_node(csm_linked_list_node_t *node);
@@ -58,13 +58,40 @@ csm_linked_list_err_t csm_linked_list_find_node(csm_linked_list_t *list, void **
   return CSM_ERR_LINKED_LIST_NOT_FOUND;
 }
 
+csm_linked_list_err_t csm_linked_list_find_node_move_to_front(csm_linked_list_t *list, void **data,
+                                                              csm_comparator predicate, void *predicate_data) {
+  csm_linked_list_node_t *p = list->head;
+  if (p == CSM_NULL) {
+    return CSM_ERR_LINKED_LIST_EMPTY;
+  }
+  csm_linked_list_node_t *prev = CSM_NULL;
+  while (p != CSM_NULL) {
+    if (predicate(p->data, predicate_data) == CSM_TRUE) {
+      if (prev != CSM_NULL) {
+        prev->next = p->next;
+        p->next = list->head;
+        list->head = p;
+      }
+      *data = p->data;
+      return CSM_ERR_LINKED_LIST_OK;
+    }
+    prev = p;
+    p = p->next;
+  }
+  return CSM_ERR_LINKED_LIST_NOT_FOUND;
+}
+
 csm_linked_list_err_t csm_linked_list_append_node(csm_linked_list_t *list, void *data) {
   csm_linked_list_node_t *new_node;
   csm_linked_list_err_t ret = malloc_node(&new_node);
   if (ret != CSM_ERR_LINKED_LIST_OK) {
     return ret;
   }
+  return csm_linked_list_append_allocated_node(list, new_node, data);
+}
 
+csm_linked_list_err_t csm_linked_list_append_allocated_node(csm_linked_list_t *list, csm_linked_list_node_t *new_node,
+                                                            void *data) {
   new_node->data = data;
   new_node->next = CSM_NULL;
 
@@ -106,6 +133,20 @@ csm_linked_list_err_t csm_linked_list_remove_node(csm_linked_list_t *list, csm_c
   return CSM_ERR_LINKED_LIST_NOT_FOUND;
 }
 
+csm_linked_list_err_t csm_linked_list_clear(csm_linked_list_t *list) {
+  csm_linked_list_node_t *ptr = list->head;
+  csm_linked_list_err_t ret = CSM_ERR_LINKED_LIST_OK;
+  while (ptr != CSM_NULL) {
+    csm_linked_list_node_t *next = ptr->next;
+    if (free_node(ptr) != CSM_ERR_LINKED_LIST_OK) {
+      ret = CSM_ERR_LINKED_LIST_ILLEGAL_STATE;
+    }
+    ptr = next;
+  }
+  list->head = CSM_NULL;
+  return ret;
+}
+
 static csm_linked_list_err_t malloc_node(csm_linked_list_node_t **node_ptr) {
   pool_state state;
   int i = 0;
@@ -148,7 +189,7 @@ inline void set_node_state_occupied(int i) {
 inline void set_node_state_free(int i) {
   int j = i / 8;
   int k = i % 8;
-  node_pool_state[j] &= 0xff & (0 << k);
+  node_pool_state[j] &= 0xff & ~(1 << k);
 }
 
 csm_linked_list_node_t *csm_linked_list_get_tail(csm_linked_list_t *list) {
@@ -0,0 +1,318 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// shm_open, ftruncate and mmap are POSIX, not declared by a strict C11 build
+#define _POSIX_C_SOURCE 200809L
+
+#include "shm_store.h"
+
+#include <stdatomic.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CSM_SHM_STORE_POSIX 1
+#endif
+
+typedef _Atomic uint64_t csm_shm_word_t;
+
+#define WORD_STATE(word) ((csm_state_t)(int32_t)(uint32_t)((word) & 0xffffffffu))
+#define WORD_STATUS(word) ((csm_machine_status)(((word) >> 32) & 0xffu))
+#define WORD_SEQUENCE(word) ((uint32_t)((word) >> 40))
+#define WORD_PACK(state, status, sequence)                                                    \
+  ((uint64_t)(uint32_t)(state) | ((uint64_t)((status) & 0xffu) << 32) | \
+   ((uint64_t)((sequence) & 0xffffffu) << 40))
+
+static inline size_t align8(size_t size);
+static inline int32_t *next_state_table(csm_shm_store_header_t *header);
+static inline csm_shm_word_t *machine_word(csm_shm_store_t *store, int machine_id);
+static csm_machine_err_t change_status(csm_shm_store_t *store, int machine_id, csm_machine_status from_status,
+                                       csm_machine_status to_status);
+
+size_t csm_shm_store_size(int machine_count) {
+  return align8(sizeof(csm_shm_store_header_t)) + align8(sizeof(int32_t) * CSM_STATE_COUNT * CSM_TRANSITION_COUNT) +
+         sizeof(uint64_t) * (size_t)machine_count;
+}
+
+csm_machine_err_t csm_shm_store_format(void *base, size_t size, csm_state_machine_t *definition, int machine_count) {
+  if (machine_count < 0 || size < csm_shm_store_size(machine_count) || ((uintptr_t)base & 7) != 0 ||
+      definition->init_state < 0 || definition->init_state >= CSM_STATE_COUNT) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  csm_shm_store_header_t *header = (csm_shm_store_header_t *)base;
+  if (ATOMIC_LLONG_LOCK_FREE != 2) {
+    // a lock based atomic is not shared across processes
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  atomic_store_explicit((_Atomic uint32_t *)&header->magic, 0, memory_order_relaxed);
+  header->version = CSM_SHM_STORE_VERSION;
+  header->state_count = CSM_STATE_COUNT;
+  header->transition_count = CSM_TRANSITION_COUNT;
+  header->machine_count = (uint32_t)machine_count;
+  header->init_state = definition->init_state;
+  header->table_offset = align8(sizeof(csm_shm_store_header_t));
+  header->machine_offset = header->table_offset + align8(sizeof(int32_t) * CSM_STATE_COUNT * CSM_TRANSITION_COUNT);
+  header->size = csm_shm_store_size(machine_count);
+
+  // flatten the linked lists into a dense table, first definition wins like csm_machine_transit
+  int32_t *table = next_state_table(header);
+  for (int i = 0; i < CSM_STATE_COUNT * CSM_TRANSITION_COUNT; i++) {
+    table[i] = CSM_SHM_STORE_NO_TRANSITION;
+  }
+  for (int s = 0; s < CSM_STATE_COUNT; s++) {
+    for (csm_linked_list_node_t *p = definition->state_transition_linked_list[s].head; p != CSM_NULL; p = p->next) {
+      csm_state_transition_node_t *node = (csm_state_transition_node_t *)p->data;
+      int32_t *slot = &table[s * CSM_TRANSITION_COUNT + node->transition];
+      if (*slot == CSM_SHM_STORE_NO_TRANSITION) {
+        *slot = node->to_state;
+      }
+    }
+  }
+
+  csm_shm_word_t *words = (csm_shm_word_t *)((unsigned char *)base + header->machine_offset);
+  for (int i = 0; i < machine_count; i++) {
+    atomic_init(&words[i], WORD_PACK(definition->init_state, CSM_MACHINE_STATUS_NEW, 0));
+  }
+
+  // publish the segment only once it is complete
+  atomic_store_explicit((_Atomic uint32_t *)&header->magic, CSM_SHM_STORE_MAGIC, memory_order_release);
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_shm_store_attach(csm_shm_store_t *store, void *base) {
+  csm_shm_store_header_t *header = (csm_shm_store_header_t *)base;
+  if (atomic_load_explicit((_Atomic uint32_t *)&header->magic, memory_order_acquire) != CSM_SHM_STORE_MAGIC ||
+      header->version != CSM_SHM_STORE_VERSION || header->state_count != CSM_STATE_COUNT ||
+      header->transition_count != CSM_TRANSITION_COUNT) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  // both tables must be aligned, in order and inside the segment
+  uint64_t table_size = sizeof(int32_t) * CSM_STATE_COUNT * CSM_TRANSITION_COUNT;
+  uint64_t machine_size = sizeof(uint64_t) * (uint64_t)header->machine_count;
+  if ((header->table_offset & 7) != 0 || (header->machine_offset & 7) != 0 ||
+      header->table_offset < sizeof(csm_shm_store_header_t) || header->table_offset > header->size ||
+      header->size - header->table_offset < table_size || header->machine_offset < header->table_offset + table_size ||
+      header->machine_offset > header->size || header->size - header->machine_offset < machine_size) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  // any process can write the segment, every state read from it must be in range
+  if (header->init_state < 0 || header->init_state >= CSM_STATE_COUNT) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  int32_t *table = next_state_table(header);
+  for (int i = 0; i < CSM_STATE_COUNT * CSM_TRANSITION_COUNT; i++) {
+    if (table[i] != CSM_SHM_STORE_NO_TRANSITION && (table[i] < 0 || table[i] >= CSM_STATE_COUNT)) {
+      return CSM_MACHINE_ERR_FAILED;
+    }
+  }
+  store->header = header;
+  store->mapped_size = 0;
+  return CSM_MACHINE_ERR_OK;
+}
+
+#ifdef CSM_SHM_STORE_POSIX
+csm_machine_err_t csm_shm_store_open(csm_shm_store_t *store, const char *name, csm_state_machine_t *definition,
+                                     int machine_count) {
+  int fd;
+  size_t size;
+  if (definition != CSM_NULL) {
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    size = csm_shm_store_size(machine_count);
+    if (fd >= 0 && ftruncate(fd, (off_t)size) != 0) {
+      close(fd);
+      shm_unlink(name);
+      return CSM_MACHINE_ERR_FAILED;
+    }
+  } else {
+    fd = shm_open(name, O_RDWR, 0600);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) != 0) {
+      close(fd);
+      return CSM_MACHINE_ERR_FAILED;
+    }
+    size = fd >= 0 ? (size_t)st.st_size : 0;
+  }
+  if (fd < 0) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  void *base = mmap(CSM_NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+
+  csm_machine_err_t ret = size >= sizeof(csm_shm_store_header_t) ? CSM_MACHINE_ERR_OK : CSM_MACHINE_ERR_FAILED;
+  if (ret == CSM_MACHINE_ERR_OK && definition != CSM_NULL) {
+    ret = csm_shm_store_format(base, size, definition, machine_count);
+  }
+  if (ret == CSM_MACHINE_ERR_OK) {
+    ret = csm_shm_store_attach(store, base);
+  }
+  if (ret == CSM_MACHINE_ERR_OK && store->header->size > size) {
+    ret = CSM_MACHINE_ERR_FAILED;
+  }
+  if (ret != CSM_MACHINE_ERR_OK) {
+    munmap(base, size);
+    return ret;
+  }
+  store->mapped_size = size;
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_shm_store_close(csm_shm_store_t *store) {
+  if (store->mapped_size != 0) {
+    munmap(store->header, store->mapped_size);
+  }
+  store->header = CSM_NULL;
+  store->mapped_size = 0;
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_shm_store_unlink(const char *name) {
+  return shm_unlink(name) == 0 ? CSM_MACHINE_ERR_OK : CSM_MACHINE_ERR_FAILED;
+}
+#else
+csm_machine_err_t csm_shm_store_open(csm_shm_store_t *store, const char *name, csm_state_machine_t *definition,
+                                     int machine_count) {
+  return CSM_MACHINE_ERR_FAILED;
+}
+
+csm_machine_err_t csm_shm_store_close(csm_shm_store_t *store) {
+  store->header = CSM_NULL;
+  store->mapped_size = 0;
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_shm_store_unlink(const char *name) { return CSM_MACHINE_ERR_FAILED; }
+#endif
+
+csm_machine_err_t csm_shm_machine_start(csm_shm_store_t *store, int machine_id) {
+  return change_status(store, machine_id, CSM_MACHINE_STATUS_NEW, CSM_MACHINE_STATUS_STARTED);
+}
+
+csm_machine_err_t csm_shm_machine_transit(csm_shm_store_t *store, int machine_id, csm_transition_t transition,
+                                          csm_state_t *prev_state, csm_state_t *new_state) {
+  csm_shm_word_t *word = machine_word(store, machine_id);
+  if (word == CSM_NULL || transition < 0 || transition >= CSM_TRANSITION_COUNT) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  int32_t *table = next_state_table(store->header);
+  uint64_t current = atomic_load_explicit(word, memory_order_acquire);
+  uint64_t desired;
+  int32_t to_state;
+  do {
+    if (WORD_STATUS(current) != CSM_MACHINE_STATUS_STARTED) {
+      return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+    }
+    if (WORD_STATE(current) < 0 || WORD_STATE(current) >= CSM_STATE_COUNT) {
+      // the word was corrupted by another process
+      return CSM_MACHINE_ERR_FAILED;
+    }
+    to_state = table[WORD_STATE(current) * CSM_TRANSITION_COUNT + transition];
+    if (to_state == CSM_SHM_STORE_NO_TRANSITION) {
+      return CSM_MACHINE_ERR_ILLEGAL_TRANSITION;
+    }
+    desired = WORD_PACK(to_state, CSM_MACHINE_STATUS_STARTED, WORD_SEQUENCE(current) + 1);
+  } while (!atomic_compare_exchange_weak_explicit(word, &current, desired, memory_order_acq_rel,
+                                                  memory_order_acquire));
+  if (prev_state != CSM_NULL) {
+    *prev_state = WORD_STATE(current);
+  }
+  if (new_state != CSM_NULL) {
+    *new_state = to_state;
+  }
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_shm_machine_stop(csm_shm_store_t *store, int machine_id) {
+  return change_status(store, machine_id, CSM_MACHINE_STATUS_STARTED, CSM_MACHINE_STATUS_STOPPED);
+}
+
+csm_machine_err_t csm_shm_machine_reset(csm_shm_store_t *store, int machine_id) {
+  csm_shm_word_t *word = machine_word(store, machine_id);
+  if (word == CSM_NULL) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  uint64_t current = atomic_load_explicit(word, memory_order_acquire);
+  uint64_t desired;
+  do {
+    if (WORD_STATUS(current) != CSM_MACHINE_STATUS_STARTED && WORD_STATUS(current) != CSM_MACHINE_STATUS_STOPPED) {
+      return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+    }
+    desired = WORD_PACK(store->header->init_state, CSM_MACHINE_STATUS_STARTED, WORD_SEQUENCE(current) + 1);
+  } while (!atomic_compare_exchange_weak_explicit(word, &current, desired, memory_order_acq_rel,
+                                                  memory_order_acquire));
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_shm_machine_load(csm_shm_store_t *store, int machine_id, csm_state_t *state,
+                                       csm_machine_status *status, uint32_t *sequence) {
+  csm_shm_word_t *word = machine_word(store, machine_id);
+  if (word == CSM_NULL) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  uint64_t current = atomic_load_explicit(word, memory_order_acquire);
+  if (state != CSM_NULL) {
+    *state = WORD_STATE(current);
+  }
+  if (status != CSM_NULL) {
+    *status = WORD_STATUS(current);
+  }
+  if (sequence != CSM_NULL) {
+    *sequence = WORD_SEQUENCE(current);
+  }
+  return CSM_MACHINE_ERR_OK;
+}
+
+static csm_machine_err_t change_status(csm_shm_store_t *store, int machine_id, csm_machine_status from_status,
+                                       csm_machine_status to_status) {
+  csm_shm_word_t *word = machine_word(store, machine_id);
+  if (word == CSM_NULL) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  uint64_t current = atomic_load_explicit(word, memory_order_acquire);
+  uint64_t desired;
+  do {
+    if (WORD_STATUS(current) != from_status) {
+      return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+    }
+    desired = WORD_PACK(WORD_STATE(current), to_status, WORD_SEQUENCE(current) + 1);
+  } while (!atomic_compare_exchange_weak_explicit(word, &current, desired, memory_order_acq_rel,
+                                                  memory_order_acquire));
+  return CSM_MACHINE_ERR_OK;
+}
+
+static inline size_t align8(size_t size) { return (size + 7) & ~(size_t)7; }
+
+static inline int32_t *next_state_table(csm_shm_store_header_t *header) {
+  return (int32_t *)((unsigned char *)header + header->table_offset);
+}
+
+static inline csm_shm_word_t *machine_word(csm_shm_store_t *store, int machine_id) {
+  if (machine_id < 0 || (uint32_t)machine_id >= store->header->machine_count) {
+    return CSM_NULL;
+  }
+  return (csm_shm_word_t *)((unsigned char *)store->header + store->header->machine_offset) + machine_id;
+}
@@ -25,17 +25,65 @@
 
 #include "linked_list.h"
 
+#if CSM_FLIGHT_RECORDER_DEPTH > 0 && CONFIG_FLIGHT_RECORDER_TIMESTAMP && (defined(__x86_64__) || defined(__i386__))
+#define USE_RDTSC 1
+#include <x86intrin.h>
+#endif
+
+// list node and transition copy taken from the machine allocator in one piece
+typedef struct {
+  csm_linked_list_node_t list_node;
+  csm_state_transition_node_t transition_node;
+} allocated_transition_t;
+
 static inline csm_bool find_transition(void *current_data, void *data_to_find);
+static csm_linked_list_err_t append_transition(csm_state_machine_t *machine, csm_state_transition_node_t *trans_node);
+static void release_transitions(csm_state_machine_t *machine);
+static inline csm_bool has_transition(csm_state_machine_t *machine, csm_state_t state, csm_transition_t transition);
+static inline csm_state_transition_node_t *find_transition_node(csm_state_machine_t *machine, csm_state_t state,
+                                                                csm_transition_t transition);
+static inline void load_machine(csm_state_machine_t *machine, csm_state_t *state, csm_machine_status *status);
+static inline void record_transit(csm_state_machine_t *machine, csm_state_t prev_state, csm_transition_t transition,
+                                  csm_state_t new_state, csm_machine_err_t result);
+static csm_machine_err_t reject_transition(csm_state_machine_t *machine, csm_state_t state,
+                                           csm_transition_t transition);
+#if CONFIG_CONCURRENT_TRANSIT
+static csm_machine_err_t compare_and_set_status(csm_state_machine_t *machine, csm_machine_status from_status,
+                                                csm_machine_status to_status);
+#endif
 
 csm_machine_err_t csm_machine_initialize(csm_state_machine_t *machine, csm_state_t init_state) {
+  return csm_machine_initialize_with_allocator(machine, init_state, CSM_NULL);
+}
+
+csm_machine_err_t csm_machine_initialize_with_allocator(csm_state_machine_t *machine, csm_state_t init_state,
+                                                        csm_allocator_t *allocator) {
+#if CONFIG_CONCURRENT_TRANSIT
+  atomic_init(&machine->machine_word, CSM_MACHINE_WORD_PACK(init_state, CSM_MACHINE_STATUS_NEW));
+#else
   machine->internal_machine_status = CSM_MACHINE_STATUS_NEW;
   machine->current_state = init_state;
+#endif
   machine->init_state = init_state;
   for (int i = 0; i < CSM_STATE_COUNT; i++) {
     machine->state_transition_linked_list[i].head = CSM_NULL;
+    for (int j = 0; j < CSM_TRANSITION_MASK_WORDS; j++) {
+      machine->state_transition_mask[i][j] = 0;
+    }
   }
   machine->on_machine_status_changed = CSM_NULL;
   machine->on_state_changed = CSM_NULL;
+  machine->on_illegal_transition = CSM_NULL;
+  machine->allocator = allocator;
+  machine->adaptive_transition_order = CSM_FALSE;
+#if CSM_FLIGHT_RECORDER_DEPTH > 0
+  machine->flight_record_count = 0;
+#if CONFIG_CONCURRENT_TRANSIT
+  for (int i = 0; i < CSM_FLIGHT_RECORDER_DEPTH; i++) {
+    atomic_init(&machine->flight_records[i].sequence, 0);
+  }
+#endif
+#endif
   return CSM_MACHINE_ERR_OK;
 }
 
@@ -51,22 +99,120 @@ csm_machine_err_t csm_machine_register_on_machine_status_changed(
   return CSM_MACHINE_ERR_OK;
 }
 
+csm_machine_err_t csm_machine_register_on_illegal_transition(csm_state_machine_t *machine,
+                                                             csm_machine_on_illegal_transition on_illegal_transition) {
+  machine->on_illegal_transition = on_illegal_transition;
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_machine_set_adaptive_transition_order(csm_state_machine_t *machine, csm_bool enable) {
+#if CONFIG_CONCURRENT_TRANSIT
+  if (enable == CSM_TRUE) {
+    // transits walk the lists without lock
+    return CSM_MACHINE_ERR_FAILED;
+  }
+#endif
+  machine->adaptive_transition_order = enable;
+  return CSM_MACHINE_ERR_OK;
+}
+
 csm_machine_err_t csm_machine_define_state_transition(csm_state_machine_t *machine,
                                                       csm_state_transition_node_t *trans_node) {
-  if (machine->internal_machine_status != CSM_MACHINE_STATUS_NEW) {
+  if (csm_machine_get_status(machine) != CSM_MACHINE_STATUS_NEW) {
     // can only define transition when machine in new status
     return CSM_MACHINE_ERR_ILLEGAL_STATUS;
   }
-  csm_linked_list_t *linked_list = &machine->state_transition_linked_list[trans_node->from_state];
-  csm_linked_list_append_node(linked_list, trans_node);
+  if (trans_node->from_state < 0 || trans_node->from_state >= CSM_STATE_COUNT || trans_node->to_state < 0 ||
+      trans_node->to_state >= CSM_STATE_COUNT || trans_node->transition < 0 ||
+      trans_node->transition >= CSM_TRANSITION_COUNT) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  if (append_transition(machine, trans_node) != CSM_ERR_LINKED_LIST_OK) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  machine->state_transition_mask[trans_node->from_state][trans_node->transition / CSM_TRANSITION_MASK_BITS] |=
+      (csm_transition_mask_t)1 << (trans_node->transition % CSM_TRANSITION_MASK_BITS);
+  return CSM_MACHINE_ERR_OK;
+}
+
+#if CONFIG_CONCURRENT_TRANSIT
+csm_machine_err_t csm_machine_dealloc(csm_state_machine_t *machine) {
+  csm_machine_err_t ret = compare_and_set_status(machine, CSM_MACHINE_STATUS_STOPPED, CSM_MACHINE_STATUS_DESTROYED);
+  if (ret == CSM_MACHINE_ERR_OK) {
+    release_transitions(machine);
+  }
+  return ret;
+}
+
+csm_machine_err_t csm_machine_start(csm_state_machine_t *machine) {
+  csm_machine_err_t ret = compare_and_set_status(machine, CSM_MACHINE_STATUS_NEW, CSM_MACHINE_STATUS_STARTED);
+  if (ret == CSM_MACHINE_ERR_OK && machine->on_machine_status_changed != CSM_NULL) {
+    machine->on_machine_status_changed(machine, CSM_MACHINE_STATUS_NEW, CSM_MACHINE_STATUS_STARTED);
+  }
+  return ret;
+}
+
+csm_machine_err_t csm_machine_transit(csm_state_machine_t *machine, csm_transition_t transition) {
+  csm_machine_word_t current = atomic_load_explicit(&machine->machine_word, memory_order_acquire);
+  csm_machine_word_t desired;
+  csm_state_transition_node_t *found_node;
+  do {
+    if (CSM_MACHINE_WORD_STATUS(current) != CSM_MACHINE_STATUS_STARTED) {
+      return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+    }
+    if (has_transition(machine, CSM_MACHINE_WORD_STATE(current), transition) != CSM_TRUE) {
+      return reject_transition(machine, CSM_MACHINE_WORD_STATE(current), transition);
+    }
+    found_node = find_transition_node(machine, CSM_MACHINE_WORD_STATE(current), transition);
+    if (found_node == CSM_NULL) {
+      return reject_transition(machine, CSM_MACHINE_WORD_STATE(current), transition);
+    }
+    // on failure `current` is reloaded and the lookup is done again from the new state
+    desired = CSM_MACHINE_WORD_PACK(found_node->to_state, CSM_MACHINE_STATUS_STARTED);
+  } while (!atomic_compare_exchange_weak_explicit(&machine->machine_word, &current, desired, memory_order_acq_rel,
+                                                  memory_order_acquire));
+  record_transit(machine, CSM_MACHINE_WORD_STATE(current), transition, found_node->to_state, CSM_MACHINE_ERR_OK);
+
+  if (machine->on_state_changed != CSM_NULL) {
+    // trigger state change callback with the state pair this thread won
+    machine->on_state_changed(machine, CSM_MACHINE_WORD_STATE(current), found_node->to_state);
+  }
   return CSM_MACHINE_ERR_OK;
 }
 
+csm_machine_err_t csm_machine_stop(csm_state_machine_t *machine) {
+  csm_machine_err_t ret = compare_and_set_status(machine, CSM_MACHINE_STATUS_STARTED, CSM_MACHINE_STATUS_STOPPED);
+  if (ret == CSM_MACHINE_ERR_OK && machine->on_machine_status_changed != CSM_NULL) {
+    machine->on_machine_status_changed(machine, CSM_MACHINE_STATUS_STARTED, CSM_MACHINE_STATUS_STOPPED);
+  }
+  return ret;
+}
+
+csm_machine_err_t csm_machine_reset(csm_state_machine_t *machine) {
+  csm_machine_word_t current = atomic_load_explicit(&machine->machine_word, memory_order_acquire);
+  csm_machine_word_t desired = CSM_MACHINE_WORD_PACK(machine->init_state, CSM_MACHINE_STATUS_STARTED);
+  do {
+    csm_machine_status status = CSM_MACHINE_WORD_STATUS(current);
+    if (status != CSM_MACHINE_STATUS_STARTED && status != CSM_MACHINE_STATUS_STOPPED) {
+      return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(&machine->machine_word, &current, desired, memory_order_acq_rel,
+                                                  memory_order_acquire));
+  if (machine->on_machine_status_changed != CSM_NULL) {
+    machine->on_machine_status_changed(machine, CSM_MACHINE_WORD_STATUS(current), CSM_MACHINE_STATUS_STARTED);
+  }
+  if (machine->on_state_changed != CSM_NULL) {
+    machine->on_state_changed(machine, CSM_MACHINE_WORD_STATE(current), machine->init_state);
+  }
+  return CSM_MACHINE_ERR_OK;
+}
+#else
 csm_machine_err_t csm_machine_dealloc(csm_state_machine_t *machine) {
   if (machine->internal_machine_status != CSM_MACHINE_STATUS_STOPPED) {
     return CSM_MACHINE_ERR_ILLEGAL_STATUS;
   }
   machine->internal_machine_status = CSM_MACHINE_STATUS_DESTROYED;
+  release_transitions(machine);
   return CSM_MACHINE_ERR_OK;
 }
 
@@ -85,17 +231,15 @@ csm_machine_err_t csm_machine_transit(csm_state_machine_t *machine, csm_transiti
   if (machine->internal_machine_status != CSM_MACHINE_STATUS_STARTED) {
     return CSM_MACHINE_ERR_ILLEGAL_STATUS;
   }
-  csm_linked_list_t *linked_list = &machine->state_transition_linked_list[machine->current_state];
-
-  csm_state_transition_node_t find_criteria = {
-      .transition = transition,
-  };
-  csm_state_transition_node_t *found_node;
-  csm_linked_list_err_t ret =
-      csm_linked_list_find_node(linked_list, (void **)&found_node, find_transition, &find_criteria);
-  if (ret != CSM_ERR_LINKED_LIST_OK) {
-    return CSM_MACHINE_ERR_ILLEGAL_TRANSITION;
+  if (has_transition(machine, machine->current_state, transition) != CSM_TRUE) {
+    // reject without walking the linked list
+    return reject_transition(machine, machine->current_state, transition);
+  }
+  csm_state_transition_node_t *found_node = find_transition_node(machine, machine->current_state, transition);
+  if (found_node == CSM_NULL) {
+    return reject_transition(machine, machine->current_state, transition);
   }
+  record_transit(machine, machine->current_state, transition, found_node->to_state, CSM_MACHINE_ERR_OK);
 
   if (machine->on_state_changed != CSM_NULL) {
     // trigger state change callback
@@ -132,6 +276,311 @@ csm_machine_err_t csm_machine_reset(csm_state_machine_t *machine) {
   machine->internal_machine_status = CSM_MACHINE_STATUS_STARTED;
   return CSM_MACHINE_ERR_OK;
 }
+#endif
+
+csm_state_t csm_machine_get_current_state(csm_state_machine_t *machine) {
+  csm_state_t state;
+  csm_machine_status status;
+  load_machine(machine, &state, &status);
+  return state;
+}
+
+csm_machine_status csm_machine_get_status(csm_state_machine_t *machine) {
+  csm_state_t state;
+  csm_machine_status status;
+  load_machine(machine, &state, &status);
+  return status;
+}
+
+csm_machine_err_t csm_machine_find_transition(csm_state_machine_t *machine, csm_state_t state,
+                                              csm_transition_t transition, csm_state_t *to_state) {
+  if (state < 0 || state >= CSM_STATE_COUNT) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  if (has_transition(machine, state, transition) != CSM_TRUE) {
+    return CSM_MACHINE_ERR_ILLEGAL_TRANSITION;
+  }
+  csm_state_transition_node_t *found_node = find_transition_node(machine, state, transition);
+  if (found_node == CSM_NULL) {
+    return CSM_MACHINE_ERR_ILLEGAL_TRANSITION;
+  }
+  *to_state = found_node->to_state;
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_machine_transit_with_next_states(csm_state_machine_t *machine, csm_transition_t transition,
+                                                       const csm_next_state_t *next_states) {
+#if CONFIG_CONCURRENT_TRANSIT
+  csm_machine_word_t current = atomic_load_explicit(&machine->machine_word, memory_order_acquire);
+  csm_machine_word_t desired;
+  csm_state_t to_state;
+  do {
+    if (CSM_MACHINE_WORD_STATUS(current) != CSM_MACHINE_STATUS_STARTED) {
+      return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+    }
+    to_state = next_states[CSM_MACHINE_WORD_STATE(current)];
+    if (to_state == CSM_STATE_COUNT) {
+      return CSM_MACHINE_ERR_ILLEGAL_TRANSITION;
+    }
+    desired = CSM_MACHINE_WORD_PACK(to_state, CSM_MACHINE_STATUS_STARTED);
+  } while (!atomic_compare_exchange_weak_explicit(&machine->machine_word, &current, desired, memory_order_acq_rel,
+                                                  memory_order_acquire));
+  csm_state_t from_state = CSM_MACHINE_WORD_STATE(current);
+#else
+  if (machine->internal_machine_status != CSM_MACHINE_STATUS_STARTED) {
+    return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+  }
+  csm_state_t from_state = machine->current_state;
+  csm_state_t to_state = next_states[from_state];
+  if (to_state == CSM_STATE_COUNT) {
+    return CSM_MACHINE_ERR_ILLEGAL_TRANSITION;
+  }
+#endif
+  record_transit(machine, from_state, transition, to_state, CSM_MACHINE_ERR_OK);
+  if (machine->on_state_changed != CSM_NULL) {
+    machine->on_state_changed(machine, from_state, to_state);
+  }
+#if !CONFIG_CONCURRENT_TRANSIT
+  machine->current_state = to_state;
+#endif
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_machine_flight_records(csm_state_machine_t *machine, csm_flight_record_t *records, int capacity,
+                                             int *count) {
+#if CSM_FLIGHT_RECORDER_DEPTH > 0
+#if CONFIG_CONCURRENT_TRANSIT
+  uint32_t total = atomic_load_explicit(&machine->flight_record_count, memory_order_acquire);
+#else
+  uint32_t total = machine->flight_record_count;
+#endif
+  int n = total < CSM_FLIGHT_RECORDER_DEPTH ? (int)total : CSM_FLIGHT_RECORDER_DEPTH;
+  if (n > capacity) {
+    n = capacity;
+  }
+#if CONFIG_CONCURRENT_TRANSIT
+  int copied = 0;
+  for (int i = 0; i < n; i++) {
+    uint32_t index = total - (uint32_t)n + (uint32_t)i;
+    csm_flight_slot_t *slot = &machine->flight_records[index & (CSM_FLIGHT_RECORDER_DEPTH - 1)];
+    uint32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence != index * 2 + 2) {
+      // not written yet, dropped, or already overwritten
+      continue;
+    }
+    csm_flight_record_t *record = &records[copied];
+    record->timestamp = atomic_load_explicit(&slot->timestamp, memory_order_relaxed);
+    record->prev_state = atomic_load_explicit(&slot->prev_state, memory_order_relaxed);
+    record->transition = atomic_load_explicit(&slot->transition, memory_order_relaxed);
+    record->new_state = atomic_load_explicit(&slot->new_state, memory_order_relaxed);
+    record->result = atomic_load_explicit(&slot->result, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) == sequence) {
+      copied++;
+    }
+  }
+  *count = copied;
+#else
+  for (int i = 0; i < n; i++) {
+    records[i] = machine->flight_records[(total - n + i) & (CSM_FLIGHT_RECORDER_DEPTH - 1)];
+  }
+  *count = n;
+#endif
+#else
+  *count = 0;
+#endif
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_bool csm_machine_can_transit(csm_state_machine_t *machine, csm_transition_t transition) {
+  csm_state_t state;
+  csm_machine_status status;
+  load_machine(machine, &state, &status);
+  if (status != CSM_MACHINE_STATUS_STARTED) {
+    return CSM_FALSE;
+  }
+  return has_transition(machine, state, transition);
+}
+
+csm_machine_err_t csm_machine_can_transit_bulk(csm_state_machine_t *const *machines, int machine_count,
+                                               csm_transition_t transition, csm_bool *results) {
+  if (transition < 0 || transition >= CSM_TRANSITION_COUNT) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  int word = transition / CSM_TRANSITION_MASK_BITS;
+  csm_transition_mask_t bit = (csm_transition_mask_t)1 << (transition % CSM_TRANSITION_MASK_BITS);
+  for (int i = 0; i < machine_count; i++) {
+    csm_state_t state;
+    csm_machine_status status;
+    load_machine(machines[i], &state, &status);
+    results[i] = (status == CSM_MACHINE_STATUS_STARTED && (machines[i]->state_transition_mask[state][word] & bit) != 0)
+                     ? CSM_TRUE
+                     : CSM_FALSE;
+  }
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_machine_err_t csm_machine_available_transitions(csm_state_machine_t *machine, csm_transition_t *transitions,
+                                                    int capacity, int *count) {
+  csm_state_t state;
+  csm_machine_status status;
+  load_machine(machine, &state, &status);
+  if (status != CSM_MACHINE_STATUS_STARTED) {
+    return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+  }
+  csm_transition_mask_t *mask = machine->state_transition_mask[state];
+  int n = 0;
+  for (int i = 0; i < CSM_TRANSITION_MASK_WORDS; i++) {
+    csm_transition_mask_t word = mask[i];
+    for (int j = 0; word != 0; j++, word >>= 1) {
+      if ((word & 1) == 0) {
+        continue;
+      }
+      if (n < capacity) {
+        transitions[n] = i * CSM_TRANSITION_MASK_BITS + j;
+      }
+      n++;
+    }
+  }
+  *count = n;
+  return CSM_MACHINE_ERR_OK;
+}
+
+static inline csm_bool has_transition(csm_state_machine_t *machine, csm_state_t state, csm_transition_t transition) {
+  if (transition < 0 || transition >= CSM_TRANSITION_COUNT) {
+    return CSM_FALSE;
+  }
+  csm_transition_mask_t word = machine->state_transition_mask[state][transition / CSM_TRANSITION_MASK_BITS];
+  return (word >> (transition % CSM_TRANSITION_MASK_BITS)) & 1 ? CSM_TRUE : CSM_FALSE;
+}
+
+static csm_linked_list_err_t append_transition(csm_state_machine_t *machine, csm_state_transition_node_t *trans_node) {
+  csm_linked_list_t *linked_list = &machine->state_transition_linked_list[trans_node->from_state];
+  if (machine->allocator == CSM_NULL) {
+    return csm_linked_list_append_node(linked_list, trans_node);
+  }
+  allocated_transition_t *allocated =
+      machine->allocator->alloc(machine->allocator->context, sizeof(allocated_transition_t));
+  if (allocated == CSM_NULL) {
+    return CSM_ERR_LINKED_LIST_NO_SPACE;
+  }
+  allocated->transition_node = *trans_node;
+  return csm_linked_list_append_allocated_node(linked_list, &allocated->list_node, &allocated->transition_node);
+}
+
+static void release_transitions(csm_state_machine_t *machine) {
+  if (machine->allocator != CSM_NULL) {
+    // everything came from the allocator, drop it at once
+    machine->allocator->release(machine->allocator->context);
+  }
+  for (int i = 0; i < CSM_STATE_COUNT; i++) {
+    if (machine->allocator == CSM_NULL) {
+      csm_linked_list_clear(&machine->state_transition_linked_list[i]);
+    }
+    machine->state_transition_linked_list[i].head = CSM_NULL;
+    for (int j = 0; j < CSM_TRANSITION_MASK_WORDS; j++) {
+      machine->state_transition_mask[i][j] = 0;
+    }
+  }
+}
+
+static inline csm_state_transition_node_t *find_transition_node(csm_state_machine_t *machine, csm_state_t state,
+                                                                csm_transition_t transition) {
+  csm_state_transition_node_t find_criteria = {
+      .transition = transition,
+  };
+  csm_state_transition_node_t *found_node;
+  csm_linked_list_t *linked_list = &machine->state_transition_linked_list[state];
+  csm_linked_list_err_t ret;
+  if (machine->adaptive_transition_order == CSM_TRUE) {
+    ret = csm_linked_list_find_node_move_to_front(linked_list, (void **)&found_node, find_transition, &find_criteria);
+  } else {
+    ret = csm_linked_list_find_node(linked_list, (void **)&found_node, find_transition, &find_criteria);
+  }
+  return ret == CSM_ERR_LINKED_LIST_OK ? found_node : CSM_NULL;
+}
+
+static inline void load_machine(csm_state_machine_t *machine, csm_state_t *state, csm_machine_status *status) {
+#if CONFIG_CONCURRENT_TRANSIT
+  csm_machine_word_t word = atomic_load_explicit(&machine->machine_word, memory_order_acquire);
+  *state = CSM_MACHINE_WORD_STATE(word);
+  *status = CSM_MACHINE_WORD_STATUS(word);
+#else
+  *state = machine->current_state;
+  *status = machine->internal_machine_status;
+#endif
+}
+
+static inline uint64_t read_cycle_counter(void) {
+#if !CONFIG_FLIGHT_RECORDER_TIMESTAMP
+  return 0;
+#elif defined(USE_RDTSC)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t value;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(value));
+  return value;
+#else
+  return 0;
+#endif
+}
+
+static inline void record_transit(csm_state_machine_t *machine, csm_state_t prev_state, csm_transition_t transition,
+                                  csm_state_t new_state, csm_machine_err_t result) {
+#if CSM_FLIGHT_RECORDER_DEPTH > 0
+#if CONFIG_CONCURRENT_TRANSIT
+  uint32_t index = atomic_fetch_add_explicit(&machine->flight_record_count, 1, memory_order_relaxed);
+  csm_flight_slot_t *slot = &machine->flight_records[index & (CSM_FLIGHT_RECORDER_DEPTH - 1)];
+  uint32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+  do {
+    // drop the record if another thread is writing the slot, or already wrote a more recent transit to it
+    if ((sequence & 1) != 0 || (int32_t)(sequence - (index * 2 + 2)) >= 0) {
+      return;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(&slot->sequence, &sequence, index * 2 + 1, memory_order_acquire,
+                                                  memory_order_relaxed));
+  atomic_store_explicit(&slot->timestamp, read_cycle_counter(), memory_order_relaxed);
+  atomic_store_explicit(&slot->prev_state, prev_state, memory_order_relaxed);
+  atomic_store_explicit(&slot->transition, transition, memory_order_relaxed);
+  atomic_store_explicit(&slot->new_state, new_state, memory_order_relaxed);
+  atomic_store_explicit(&slot->result, result, memory_order_relaxed);
+  atomic_store_explicit(&slot->sequence, index * 2 + 2, memory_order_release);
+#else
+  uint32_t index = machine->flight_record_count++;
+  csm_flight_record_t *record = &machine->flight_records[index & (CSM_FLIGHT_RECORDER_DEPTH - 1)];
+  record->timestamp = read_cycle_counter();
+  record->prev_state = prev_state;
+  record->transition = transition;
+  record->new_state = new_state;
+  record->result = result;
+#endif
+#endif
+}
+
+static csm_machine_err_t reject_transition(csm_state_machine_t *machine, csm_state_t state,
+                                           csm_transition_t transition) {
+  record_transit(machine, state, transition, state, CSM_MACHINE_ERR_ILLEGAL_TRANSITION);
+  if (machine->on_illegal_transition != CSM_NULL) {
+    machine->on_illegal_transition(machine, state, transition);
+  }
+  return CSM_MACHINE_ERR_ILLEGAL_TRANSITION;
+}
+
+#if CONFIG_CONCURRENT_TRANSIT
+static csm_machine_err_t compare_and_set_status(csm_state_machine_t *machine, csm_machine_status from_status,
+                                                csm_machine_status to_status) {
+  csm_machine_word_t current = atomic_load_explicit(&machine->machine_word, memory_order_acquire);
+  csm_machine_word_t desired;
+  do {
+    if (CSM_MACHINE_WORD_STATUS(current) != from_status) {
+      return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+    }
+    desired = CSM_MACHINE_WORD_PACK(CSM_MACHINE_WORD_STATE(current), to_status);
+  } while (!atomic_compare_exchange_weak_explicit(&machine->machine_word, &current, desired, memory_order_acq_rel,
+                                                  memory_order_acquire));
+  return CSM_MACHINE_ERR_OK;
+}
+#endif
 
 static inline csm_bool find_transition(void *current_data, void *data_to_find) {
   return ((csm_state_transition_node_t *)current_data)->transition ==
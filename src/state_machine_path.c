@@ -0,0 +1,140 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "state_machine_path.h"
+
+static inline void set_state_bit(csm_state_mask_t *row, csm_state_t state);
+static inline csm_bool get_state_bit(const csm_state_mask_t *row, csm_state_t state);
+static inline csm_bool first_definition(csm_transition_mask_t *seen, csm_transition_t transition);
+
+csm_machine_err_t csm_path_index_build(csm_path_index_t *index, csm_state_machine_t *machine) {
+  // direct edges and the state itself
+  for (int i = 0; i < CSM_STATE_COUNT; i++) {
+    for (int w = 0; w < CSM_STATE_MASK_WORDS; w++) {
+      index->reachable[i][w] = 0;
+    }
+    set_state_bit(index->reachable[i], i);
+    csm_transition_mask_t seen[CSM_TRANSITION_MASK_WORDS] = {0};
+    for (csm_linked_list_node_t *p = machine->state_transition_linked_list[i].head; p != CSM_NULL; p = p->next) {
+      csm_state_transition_node_t *node = (csm_state_transition_node_t *)p->data;
+      if (first_definition(seen, node->transition) == CSM_TRUE) {
+        set_state_bit(index->reachable[i], node->to_state);
+      }
+    }
+  }
+
+  // transitive closure, a whole row is merged at a time
+  for (int k = 0; k < CSM_STATE_COUNT; k++) {
+    for (int i = 0; i < CSM_STATE_COUNT; i++) {
+      if (get_state_bit(index->reachable[i], k) != CSM_TRUE) {
+        continue;
+      }
+      for (int w = 0; w < CSM_STATE_MASK_WORDS; w++) {
+        index->reachable[i][w] |= index->reachable[k][w];
+      }
+    }
+  }
+
+  // breadth first search from every state, each visited state inherits the first hop of its parent
+  csm_state_t queue[CSM_STATE_COUNT];
+  for (int from = 0; from < CSM_STATE_COUNT; from++) {
+    csm_state_mask_t visited[CSM_STATE_MASK_WORDS] = {0};
+    csm_path_hop_t *hops = index->next_hop[from];
+    int head = 0;
+    int tail = 0;
+    set_state_bit(visited, from);
+    queue[tail++] = from;
+    while (head < tail) {
+      csm_state_t state = queue[head++];
+      csm_transition_mask_t seen[CSM_TRANSITION_MASK_WORDS] = {0};
+      for (csm_linked_list_node_t *p = machine->state_transition_linked_list[state].head; p != CSM_NULL;
+           p = p->next) {
+        csm_state_transition_node_t *node = (csm_state_transition_node_t *)p->data;
+        if (first_definition(seen, node->transition) != CSM_TRUE ||
+            get_state_bit(visited, node->to_state) == CSM_TRUE) {
+          continue;
+        }
+        set_state_bit(visited, node->to_state);
+        if (state == from) {
+          hops[node->to_state].transition = node->transition;
+          hops[node->to_state].state = node->to_state;
+        } else {
+          hops[node->to_state] = hops[state];
+        }
+        queue[tail++] = node->to_state;
+      }
+    }
+  }
+  return CSM_MACHINE_ERR_OK;
+}
+
+csm_bool csm_path_index_is_reachable(const csm_path_index_t *index, csm_state_t from, csm_state_t to) {
+  if (from < 0 || from >= CSM_STATE_COUNT || to < 0 || to >= CSM_STATE_COUNT) {
+    return CSM_FALSE;
+  }
+  return get_state_bit(index->reachable[from], to);
+}
+
+csm_machine_err_t csm_machine_path_to(csm_state_machine_t *machine, const csm_path_index_t *index,
+                                      csm_state_t target, csm_transition_t *transitions, int capacity,
+                                      int *length) {
+  if (csm_machine_get_status(machine) != CSM_MACHINE_STATUS_STARTED) {
+    return CSM_MACHINE_ERR_ILLEGAL_STATUS;
+  }
+  if (target < 0 || target >= CSM_STATE_COUNT) {
+    return CSM_MACHINE_ERR_FAILED;
+  }
+  csm_state_t state = csm_machine_get_current_state(machine);
+  if (get_state_bit(index->reachable[state], target) != CSM_TRUE) {
+    return CSM_MACHINE_ERR_ILLEGAL_TRANSITION;
+  }
+  int n = 0;
+  while (state != target) {
+    const csm_path_hop_t *hop = &index->next_hop[state][target];
+    if (n < capacity) {
+      transitions[n] = hop->transition;
+    }
+    n++;
+    state = hop->state;
+  }
+  *length = n;
+  return CSM_MACHINE_ERR_OK;
+}
+
+static inline void set_state_bit(csm_state_mask_t *row, csm_state_t state) {
+  row[state / CSM_STATE_MASK_BITS] |= (csm_state_mask_t)1 << (state % CSM_STATE_MASK_BITS);
+}
+
+static inline csm_bool get_state_bit(const csm_state_mask_t *row, csm_state_t state) {
+  return (row[state / CSM_STATE_MASK_BITS] >> (state % CSM_STATE_MASK_BITS)) & 1 ? CSM_TRUE : CSM_FALSE;
+}
+
+// csm_machine_transit takes the first node of a state list with the transition, later ones are shadowed
+static inline csm_bool first_definition(csm_transition_mask_t *seen, csm_transition_t transition) {
+  csm_transition_mask_t bit = (csm_transition_mask_t)1 << (transition % CSM_TRANSITION_MASK_BITS);
+  if ((seen[transition / CSM_TRANSITION_MASK_BITS] & bit) != 0) {
+    return CSM_FALSE;
+  }
+  seen[transition / CSM_TRANSITION_MASK_BITS] |= bit;
+  return CSM_TRUE;
+}
@@ -0,0 +1,81 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "allocator.h"
+
+#include <stdint.h>
+
+#include "assert.h"
+
+int test_arena_alloc_ok() {
+  max_align_t buffer[8];
+  csm_arena_t arena;
+  csm_arena_initialize(&arena, buffer, sizeof(buffer));
+
+  unsigned char *p1 = csm_arena_alloc(&arena, 1);
+  unsigned char *p2 = csm_arena_alloc(&arena, 1);
+  ASSERT_NOT_EQ(p1, CSM_NULL);
+  ASSERT_NOT_EQ(p2, CSM_NULL);
+  ASSERT_EQ((unsigned char *)buffer, p1);
+  // contiguous, aligned for any type
+  ASSERT_EQ(p1 + _Alignof(max_align_t), p2);
+  ASSERT_EQ((uintptr_t)p2 % _Alignof(max_align_t), 0);
+  return 0;
+}
+
+int test_arena_alloc_should_failed_when_no_space_left() {
+  max_align_t buffer[2];
+  csm_arena_t arena;
+  csm_arena_initialize(&arena, buffer, sizeof(buffer));
+
+  ASSERT_NOT_EQ(csm_arena_alloc(&arena, sizeof(buffer)), CSM_NULL);
+  ASSERT_EQ(csm_arena_alloc(&arena, 1), CSM_NULL);
+
+  csm_arena_release(&arena);
+  ASSERT_EQ(arena.offset, 0);
+  ASSERT_EQ(csm_arena_alloc(&arena, 1), (void *)buffer);
+  return 0;
+}
+
+int test_arena_allocator_ok() {
+  max_align_t buffer[4];
+  csm_arena_t arena;
+  csm_arena_initialize(&arena, buffer, sizeof(buffer));
+
+  csm_allocator_t allocator;
+  csm_arena_allocator(&arena, &allocator);
+  void *p = allocator.alloc(allocator.context, 8);
+  ASSERT_EQ(p, (void *)buffer);
+  ASSERT_NOT_EQ(arena.offset, 0);
+  allocator.release(allocator.context);
+  ASSERT_EQ(arena.offset, 0);
+  return 0;
+}
+
+int main() {
+  int ret = 0;
+  ret |= test_arena_alloc_ok();
+  ret |= test_arena_alloc_should_failed_when_no_space_left();
+  ret |= test_arena_allocator_ok();
+  return ret;
+}
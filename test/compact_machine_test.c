@@ -0,0 +1,150 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "compact_machine.h"
+
+#include <stddef.h>
+
+#include "assert.h"
+
+typedef enum {
+  TEST_STATE_0,
+  TEST_STATE_1,
+  TEST_STATE_2,
+} test_state;
+
+typedef enum {
+  TEST_TRANSITION_A,
+  TEST_TRANSITION_B,
+} test_transition;
+
+static int state_changed_count = 0;
+static int status_changed_count = 0;
+
+static void on_state_changed(const csm_compact_definition_t *definition, csm_compact_machine_t *instance,
+                             csm_state_t prev_state, csm_state_t new_state) {
+  state_changed_count++;
+}
+
+static void on_machine_status_changed(const csm_compact_definition_t *definition, csm_compact_machine_t *instance,
+                                      csm_machine_status prev_status, csm_machine_status new_status) {
+  status_changed_count++;
+}
+
+// the global node pool keeps pointers to the transition nodes, they must outlive the machine
+static csm_state_transition_node_t trans_node1 = {
+    .from_state = TEST_STATE_0,
+    .transition = TEST_TRANSITION_A,
+    .to_state = TEST_STATE_1,
+};
+
+static csm_state_transition_node_t trans_node2 = {
+    .from_state = TEST_STATE_1,
+    .transition = TEST_TRANSITION_B,
+    .to_state = TEST_STATE_2,
+};
+
+static int define_test_machine(csm_state_machine_t *machine) {
+  ASSERT_EQ(csm_machine_initialize(machine, TEST_STATE_0), CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_machine_define_state_transition(machine, &trans_node1), CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_machine_define_state_transition(machine, &trans_node2), CSM_MACHINE_ERR_OK);
+  return 0;
+}
+
+int test_compact_machine_word_pack_ok() {
+  csm_machine_word_t word = CSM_MACHINE_WORD_PACK(TEST_STATE_2, CSM_MACHINE_STATUS_STOPPED);
+  ASSERT_EQ(CSM_MACHINE_WORD_STATE(word), TEST_STATE_2);
+  ASSERT_EQ(CSM_MACHINE_WORD_STATUS(word), CSM_MACHINE_STATUS_STOPPED);
+  ASSERT_EQ(sizeof(csm_compact_machine_t), sizeof(csm_machine_word_t));
+#if CONFIG_STATE_WIDTH == 8
+  ASSERT_EQ(sizeof(csm_compact_machine_t), 2);
+#endif
+  return 0;
+}
+
+int test_compact_machine_should_transit_ok() {
+  csm_state_machine_t machine;
+  ASSERT_EQ(define_test_machine(&machine), 0);
+  csm_compact_definition_t definition;
+  ASSERT_EQ(csm_compact_definition_initialize(&definition, &machine), CSM_MACHINE_ERR_OK);
+
+  csm_compact_machine_t instances[2];
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(csm_compact_machine_initialize(&definition, &instances[i]), CSM_MACHINE_ERR_OK);
+    ASSERT_EQ(csm_compact_machine_get_status(&instances[i]), CSM_MACHINE_STATUS_NEW);
+    ASSERT_EQ(csm_compact_machine_get_current_state(&instances[i]), TEST_STATE_0);
+  }
+  ASSERT_EQ(csm_compact_machine_transit(&definition, &instances[0], TEST_TRANSITION_A),
+            CSM_MACHINE_ERR_ILLEGAL_STATUS);
+
+  ASSERT_EQ(csm_compact_machine_start(&definition, &instances[0]), CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_compact_machine_start(&definition, &instances[0]), CSM_MACHINE_ERR_ILLEGAL_STATUS);
+  ASSERT_EQ(csm_compact_machine_transit(&definition, &instances[0], TEST_TRANSITION_B),
+            CSM_MACHINE_ERR_ILLEGAL_TRANSITION);
+  ASSERT_EQ(csm_compact_machine_transit(&definition, &instances[0], TEST_TRANSITION_A), CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_compact_machine_transit(&definition, &instances[0], TEST_TRANSITION_B), CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_compact_machine_get_current_state(&instances[0]), TEST_STATE_2);
+  ASSERT_EQ(csm_compact_machine_get_status(&instances[0]), CSM_MACHINE_STATUS_STARTED);
+
+  // the other instance sharing the definition is untouched
+  ASSERT_EQ(csm_compact_machine_get_current_state(&instances[1]), TEST_STATE_0);
+  ASSERT_EQ(csm_compact_machine_get_status(&instances[1]), CSM_MACHINE_STATUS_NEW);
+  ASSERT_EQ(csm_machine_get_status(&machine), CSM_MACHINE_STATUS_NEW);
+  return 0;
+}
+
+int test_compact_machine_stop_and_reset_ok() {
+  csm_state_machine_t machine;
+  ASSERT_EQ(define_test_machine(&machine), 0);
+  csm_compact_definition_t definition;
+  csm_compact_definition_initialize(&definition, &machine);
+  csm_compact_register_on_state_changed(&definition, on_state_changed);
+  csm_compact_register_on_machine_status_changed(&definition, on_machine_status_changed);
+
+  csm_compact_machine_t instance;
+  csm_compact_machine_initialize(&definition, &instance);
+  ASSERT_EQ(csm_compact_machine_reset(&definition, &instance), CSM_MACHINE_ERR_ILLEGAL_STATUS);
+  state_changed_count = 0;
+  status_changed_count = 0;
+  ASSERT_EQ(csm_compact_machine_start(&definition, &instance), CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_compact_machine_transit(&definition, &instance, TEST_TRANSITION_A), CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_compact_machine_stop(&definition, &instance), CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_compact_machine_get_status(&instance), CSM_MACHINE_STATUS_STOPPED);
+  ASSERT_EQ(csm_compact_machine_get_current_state(&instance), TEST_STATE_1);
+  ASSERT_EQ(csm_compact_machine_transit(&definition, &instance, TEST_TRANSITION_B), CSM_MACHINE_ERR_ILLEGAL_STATUS);
+
+  ASSERT_EQ(csm_compact_machine_reset(&definition, &instance), CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_compact_machine_get_status(&instance), CSM_MACHINE_STATUS_STARTED);
+  ASSERT_EQ(csm_compact_machine_get_current_state(&instance), TEST_STATE_0);
+  ASSERT_EQ(state_changed_count, 2);
+  ASSERT_EQ(status_changed_count, 3);
+  return 0;
+}
+
+int main() {
+  int ret = 0;
+  ret |= test_compact_machine_word_pack_ok();
+  ret |= test_compact_machine_should_transit_ok();
+  ret |= test_compact_machine_stop_and_reset_ok();
+  return ret;
+}
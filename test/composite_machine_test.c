@@ -0,0 +1,150 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "composite_machine.h"
+
+#include "assert.h"
+
+typedef enum {
+  TEST_STATE_OFF,
+  TEST_STATE_ON,
+  TEST_STATE_ALARM,
+} test_state;
+
+typedef enum {
+  TEST_TRANSITION_POWER_ON,
+  TEST_TRANSITION_POWER_OFF,
+  TEST_TRANSITION_FAULT,
+} test_transition;
+
+// power: OFF --POWER_ON--> ON --POWER_OFF--> OFF
+static csm_state_transition_node_t power_nodes[] = {
+    {.from_state = TEST_STATE_OFF, .transition = TEST_TRANSITION_POWER_ON, .to_state = TEST_STATE_ON},
+    {.from_state = TEST_STATE_ON, .transition = TEST_TRANSITION_POWER_OFF, .to_state = TEST_STATE_OFF},
+};
+
+// link: OFF --POWER_ON--> ON --FAULT--> OFF
+static csm_state_transition_node_t link_nodes[] = {
+    {.from_state = TEST_STATE_OFF, .transition = TEST_TRANSITION_POWER_ON, .to_state = TEST_STATE_ON},
+    {.from_state = TEST_STATE_ON, .transition = TEST_TRANSITION_FAULT, .to_state = TEST_STATE_OFF},
+};
+
+// alarm: OFF --FAULT--> ALARM
+static csm_state_transition_node_t alarm_nodes[] = {
+    {.from_state = TEST_STATE_OFF, .transition = TEST_TRANSITION_FAULT, .to_state = TEST_STATE_ALARM},
+};
+
+static int setup_region(csm_state_machine_t *machine, csm_state_transition_node_t *nodes, int count) {
+  csm_machine_err_t ret = csm_machine_initialize(machine, TEST_STATE_OFF);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  for (int i = 0; i < count; i++) {
+    ret = csm_machine_define_state_transition(machine, &nodes[i]);
+    ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  }
+  ret = csm_machine_start(machine);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  return 0;
+}
+
+static int state_changed_count = 0;
+
+static void on_state_changed(csm_state_machine_t *machine, csm_state_t prev_state, csm_state_t new_state) {
+  state_changed_count++;
+}
+
+static int run_composite_transit(csm_bool parallel) {
+  csm_state_machine_t power;
+  csm_state_machine_t link;
+  csm_state_machine_t alarm;
+  ASSERT_EQ(setup_region(&power, power_nodes, 2), 0);
+  ASSERT_EQ(setup_region(&link, link_nodes, 2), 0);
+  ASSERT_EQ(setup_region(&alarm, alarm_nodes, 1), 0);
+  csm_machine_register_on_state_changed(&link, on_state_changed);
+  state_changed_count = 0;
+
+  static csm_composite_machine_t composite;
+  csm_machine_err_t ret = csm_composite_initialize(&composite);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  csm_composite_set_parallel(&composite, parallel);
+  ASSERT_EQ(csm_composite_add_region(&composite, &power), CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_composite_add_region(&composite, &link), CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_composite_add_region(&composite, &alarm), CSM_MACHINE_ERR_OK);
+
+  csm_region_mask_t changed[CSM_REGION_MASK_WORDS];
+  ret = csm_composite_transit(&composite, TEST_TRANSITION_POWER_ON, changed);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(changed[0], 0x3);
+  ASSERT_EQ(power.current_state, TEST_STATE_ON);
+  ASSERT_EQ(link.current_state, TEST_STATE_ON);
+  ASSERT_EQ(alarm.current_state, TEST_STATE_OFF);
+
+  ret = csm_composite_transit(&composite, TEST_TRANSITION_FAULT, changed);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(changed[0], 0x6);
+  ASSERT_EQ(power.current_state, TEST_STATE_ON);
+  ASSERT_EQ(link.current_state, TEST_STATE_OFF);
+  ASSERT_EQ(alarm.current_state, TEST_STATE_ALARM);
+
+  // link is OFF and alarm is ALARM, neither accepts FAULT any more
+  ret = csm_composite_transit(&composite, TEST_TRANSITION_FAULT, changed);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_ILLEGAL_TRANSITION);
+  ASSERT_EQ(changed[0], 0);
+  ASSERT_EQ(state_changed_count, 2);
+
+  ret = csm_composite_transit(&composite, CSM_TRANSITION_COUNT, changed);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_FAILED);
+  return 0;
+}
+
+int test_composite_transit_ok() { return run_composite_transit(CSM_FALSE); }
+
+int test_composite_parallel_transit_ok() { return run_composite_transit(CSM_TRUE); }
+
+int test_composite_skip_stopped_region_ok() {
+  csm_state_machine_t power;
+  csm_state_machine_t link;
+  ASSERT_EQ(setup_region(&power, power_nodes, 2), 0);
+  ASSERT_EQ(setup_region(&link, link_nodes, 2), 0);
+  ASSERT_EQ(csm_machine_stop(&link), CSM_MACHINE_ERR_OK);
+
+  static csm_composite_machine_t composite;
+  csm_composite_initialize(&composite);
+  csm_composite_add_region(&composite, &power);
+  csm_composite_add_region(&composite, &link);
+  csm_composite_set_parallel(&composite, CSM_TRUE);
+
+  csm_region_mask_t changed[CSM_REGION_MASK_WORDS];
+  csm_machine_err_t ret = csm_composite_transit(&composite, TEST_TRANSITION_POWER_ON, changed);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(changed[0], 0x1);
+  ASSERT_EQ(link.current_state, TEST_STATE_OFF);
+  return 0;
+}
+
+int main() {
+  int ret = 0;
+  ret |= test_composite_transit_ok();
+  ret |= test_composite_parallel_transit_ok();
+  ret |= test_composite_skip_stopped_region_ok();
+  return ret;
+}
@@ -81,6 +81,91 @@ int test_linked_list_append_and_find_should_ok() {
   return 0;
 }
 
+int test_linked_list_remove_should_free_only_removed_node() {
+  csm_linked_list_t linked_list = {
+      .head = CSM_NULL,
+  };
+  int data1 = 11;
+  int data2 = 22;
+  csm_linked_list_append_node(&linked_list, &data1);
+  csm_linked_list_append_node(&linked_list, &data2);
+  csm_linked_list_err_t ret = csm_linked_list_remove_node(&linked_list, csm_int_predicate, &data1);
+  ASSERT_EQ(ret, CSM_ERR_LINKED_LIST_OK);
+
+  // the node of data2 is still occupied
+  csm_linked_list_t other_list = {
+      .head = CSM_NULL,
+  };
+  int i = 0;
+  for (; i < CONFIG_NODE_POOL_SIZE; i++) {
+    if (csm_linked_list_append_node(&other_list, &i) != CSM_ERR_LINKED_LIST_OK) {
+      break;
+    }
+  }
+  ASSERT_EQ(i, CONFIG_NODE_POOL_SIZE - 1);
+
+  ret = csm_linked_list_clear(&other_list);
+  ASSERT_EQ(ret, CSM_ERR_LINKED_LIST_OK);
+  ASSERT_EQ(other_list.head, CSM_NULL);
+  ret = csm_linked_list_clear(&linked_list);
+  ASSERT_EQ(ret, CSM_ERR_LINKED_LIST_OK);
+  return 0;
+}
+
+int test_linked_list_append_allocated_node_ok() {
+  csm_linked_list_t linked_list = {
+      .head = CSM_NULL,
+  };
+  csm_linked_list_node_t node1;
+  csm_linked_list_node_t node2;
+  int data1 = 11;
+  int data2 = 22;
+  csm_linked_list_err_t ret = csm_linked_list_append_allocated_node(&linked_list, &node1, &data1);
+  ASSERT_EQ(ret, CSM_ERR_LINKED_LIST_OK);
+  ret = csm_linked_list_append_allocated_node(&linked_list, &node2, &data2);
+  ASSERT_EQ(ret, CSM_ERR_LINKED_LIST_OK);
+  ASSERT_EQ(linked_list.head, &node1);
+  ASSERT_EQ(node1.next, &node2);
+
+  void *found;
+  ret = csm_linked_list_find_node(&linked_list, &found, csm_int_predicate, &data2);
+  ASSERT_EQ(ret, CSM_ERR_LINKED_LIST_OK);
+  ASSERT_EQ(*(int *)found, 22);
+  return 0;
+}
+
+int test_linked_list_find_node_move_to_front_ok() {
+  csm_linked_list_t linked_list = {
+      .head = CSM_NULL,
+  };
+  csm_linked_list_node_t nodes[3];
+  int data[3] = {11, 22, 33};
+  for (int i = 0; i < 3; i++) {
+    csm_linked_list_append_allocated_node(&linked_list, &nodes[i], &data[i]);
+  }
+
+  void *found;
+  csm_linked_list_err_t ret =
+      csm_linked_list_find_node_move_to_front(&linked_list, &found, csm_int_predicate, &data[2]);
+  ASSERT_EQ(ret, CSM_ERR_LINKED_LIST_OK);
+  ASSERT_EQ(*(int *)found, 33);
+  // 33 -> 11 -> 22
+  ASSERT_EQ(linked_list.head, &nodes[2]);
+  ASSERT_EQ(nodes[2].next, &nodes[0]);
+  ASSERT_EQ(nodes[0].next, &nodes[1]);
+  ASSERT_EQ(nodes[1].next, CSM_NULL);
+
+  ret = csm_linked_list_find_node_move_to_front(&linked_list, &found, csm_int_predicate, &data[2]);
+  ASSERT_EQ(ret, CSM_ERR_LINKED_LIST_OK);
+  ASSERT_EQ(linked_list.head, &nodes[2]);
+
+  int missing = 99;
+  ret = csm_linked_list_find_node_move_to_front(&linked_list, &found, csm_int_predicate, &missing);
+  ASSERT_EQ(ret, CSM_ERR_LINKED_LIST_NOT_FOUND);
+  ASSERT_EQ(linked_list.head, &nodes[2]);
+  return 0;
+}
+
 int test_linked_list_should_overflow_when_no_node_left() {
   csm_linked_list_t linked_list = {
       .head = CSM_NULL,
@@ -100,6 +185,9 @@ int main() {
   int ret = 0;
   ret |= test_linked_list_append_should_ok();
   ret |= test_linked_list_append_and_find_should_ok();
+  ret |= test_linked_list_remove_should_free_only_removed_node();
+  ret |= test_linked_list_append_allocated_node_ok();
+  ret |= test_linked_list_find_node_move_to_front_ok();
   ret |= test_linked_list_should_overflow_when_no_node_left();
   return ret;
 }
@@ -0,0 +1,278 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "shm_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "assert.h"
+
+#define TEST_RING_SIZE (7)
+#define TEST_PROCESS_COUNT (4)
+#define TEST_TRANSIT_PER_PROCESS (1000)
+
+typedef enum {
+  TEST_TRANSITION_NEXT,
+  TEST_TRANSITION_HALT,
+} test_transition;
+
+// 0 --NEXT--> 1 --NEXT--> ... --NEXT--> 6 --NEXT--> 0
+static csm_state_transition_node_t trans_nodes[TEST_RING_SIZE];
+
+static int setup_definition(csm_state_machine_t *definition) {
+  csm_machine_err_t ret = csm_machine_initialize(definition, 0);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  for (int i = 0; i < TEST_RING_SIZE; i++) {
+    trans_nodes[i].from_state = i;
+    trans_nodes[i].transition = TEST_TRANSITION_NEXT;
+    trans_nodes[i].to_state = (i + 1) % TEST_RING_SIZE;
+    ret = csm_machine_define_state_transition(definition, &trans_nodes[i]);
+    ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  }
+  return 0;
+}
+
+int test_shm_store_transit_ok() {
+  csm_state_machine_t definition;
+  ASSERT_EQ(setup_definition(&definition), 0);
+
+  uint64_t buffer[1024];
+  ASSERT_EQ(csm_shm_store_size(2) <= sizeof(buffer), 1);
+  csm_machine_err_t ret = csm_shm_store_format(buffer, sizeof(buffer), &definition, 2);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  csm_shm_store_t store;
+  ret = csm_shm_store_attach(&store, buffer);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  csm_state_t prev_state;
+  csm_state_t new_state;
+  ret = csm_shm_machine_transit(&store, 0, TEST_TRANSITION_NEXT, &prev_state, &new_state);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_ILLEGAL_STATUS);
+
+  ret = csm_shm_machine_start(&store, 0);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ret = csm_shm_machine_transit(&store, 0, TEST_TRANSITION_NEXT, &prev_state, &new_state);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(prev_state, 0);
+  ASSERT_EQ(new_state, 1);
+  ret = csm_shm_machine_transit(&store, 0, TEST_TRANSITION_HALT, &prev_state, &new_state);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_ILLEGAL_TRANSITION);
+  ret = csm_shm_machine_transit(&store, 2, TEST_TRANSITION_NEXT, &prev_state, &new_state);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_FAILED);
+
+  csm_state_t state;
+  csm_machine_status status;
+  uint32_t sequence;
+  ret = csm_shm_machine_load(&store, 1, &state, &status, &sequence);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(state, 0);
+  ASSERT_EQ(status, CSM_MACHINE_STATUS_NEW);
+  ASSERT_EQ(sequence, 0);
+
+  ret = csm_shm_machine_stop(&store, 0);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ret = csm_shm_machine_reset(&store, 0);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ret = csm_shm_machine_load(&store, 0, &state, &status, &sequence);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(state, 0);
+  ASSERT_EQ(status, CSM_MACHINE_STATUS_STARTED);
+  ASSERT_EQ(sequence, 4);
+  return 0;
+}
+
+int test_shm_store_attach_should_failed_if_not_formatted() {
+  uint64_t buffer[1024] = {0};
+  csm_shm_store_t store;
+  csm_machine_err_t ret = csm_shm_store_attach(&store, buffer);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_FAILED);
+  return 0;
+}
+
+int test_shm_store_attach_should_failed_if_tables_out_of_segment() {
+  csm_state_machine_t definition;
+  ASSERT_EQ(setup_definition(&definition), 0);
+  uint64_t buffer[1024];
+  csm_shm_store_header_t *header = (csm_shm_store_header_t *)buffer;
+  csm_shm_store_t store;
+
+  ASSERT_EQ(csm_shm_store_format(buffer, sizeof(buffer), &definition, 2), CSM_MACHINE_ERR_OK);
+  header->machine_count = 1000;
+  ASSERT_EQ(csm_shm_store_attach(&store, buffer), CSM_MACHINE_ERR_FAILED);
+
+  ASSERT_EQ(csm_shm_store_format(buffer, sizeof(buffer), &definition, 2), CSM_MACHINE_ERR_OK);
+  header->machine_offset = header->size;
+  ASSERT_EQ(csm_shm_store_attach(&store, buffer), CSM_MACHINE_ERR_FAILED);
+
+  ASSERT_EQ(csm_shm_store_format(buffer, sizeof(buffer), &definition, 2), CSM_MACHINE_ERR_OK);
+  header->table_offset = UINT64_MAX - 7;
+  ASSERT_EQ(csm_shm_store_attach(&store, buffer), CSM_MACHINE_ERR_FAILED);
+
+  ASSERT_EQ(csm_shm_store_format(buffer, sizeof(buffer), &definition, 2), CSM_MACHINE_ERR_OK);
+  header->table_offset = 0;
+  ASSERT_EQ(csm_shm_store_attach(&store, buffer), CSM_MACHINE_ERR_FAILED);
+
+  ASSERT_EQ(csm_shm_store_format(buffer, sizeof(buffer), &definition, 2), CSM_MACHINE_ERR_OK);
+  header->init_state = CSM_STATE_COUNT;
+  ASSERT_EQ(csm_shm_store_attach(&store, buffer), CSM_MACHINE_ERR_FAILED);
+
+  ASSERT_EQ(csm_shm_store_format(buffer, sizeof(buffer), &definition, 2), CSM_MACHINE_ERR_OK);
+  int32_t *table = (int32_t *)((unsigned char *)buffer + header->table_offset);
+  table[CSM_TRANSITION_COUNT + TEST_TRANSITION_NEXT] = CSM_STATE_COUNT + 70;
+  ASSERT_EQ(csm_shm_store_attach(&store, buffer), CSM_MACHINE_ERR_FAILED);
+  table[CSM_TRANSITION_COUNT + TEST_TRANSITION_NEXT] = -2;
+  ASSERT_EQ(csm_shm_store_attach(&store, buffer), CSM_MACHINE_ERR_FAILED);
+
+  csm_state_machine_t bad_definition;
+  csm_machine_initialize(&bad_definition, CSM_STATE_COUNT);
+  ASSERT_EQ(csm_shm_store_format(buffer, sizeof(buffer), &bad_definition, 2), CSM_MACHINE_ERR_FAILED);
+
+  ASSERT_EQ(csm_shm_store_format(buffer, sizeof(buffer), &definition, 2), CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_shm_store_attach(&store, buffer), CSM_MACHINE_ERR_OK);
+
+  // machine word corrupted after attaching, state out of range
+  uint64_t *words = (uint64_t *)((unsigned char *)buffer + header->machine_offset);
+  words[0] = (uint64_t)(CSM_STATE_COUNT + 70) | ((uint64_t)CSM_MACHINE_STATUS_STARTED << 32);
+  ASSERT_EQ(csm_shm_machine_transit(&store, 0, TEST_TRANSITION_NEXT, CSM_NULL, CSM_NULL), CSM_MACHINE_ERR_FAILED);
+  return 0;
+}
+
+int test_shm_store_multi_process_transit_ok() {
+  csm_state_machine_t definition;
+  ASSERT_EQ(setup_definition(&definition), 0);
+
+  size_t size = csm_shm_store_size(1);
+  void *base = mmap(CSM_NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NOT_EQ(base, MAP_FAILED);
+  csm_machine_err_t ret = csm_shm_store_format(base, size, &definition, 1);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  csm_shm_store_t store;
+  ret = csm_shm_store_attach(&store, base);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ret = csm_shm_machine_start(&store, 0);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  pid_t pids[TEST_PROCESS_COUNT];
+  for (int i = 0; i < TEST_PROCESS_COUNT; i++) {
+    pids[i] = fork();
+    if (pids[i] == 0) {
+      for (int j = 0; j < TEST_TRANSIT_PER_PROCESS; j++) {
+        if (csm_shm_machine_transit(&store, 0, TEST_TRANSITION_NEXT, CSM_NULL, CSM_NULL) != CSM_MACHINE_ERR_OK) {
+          _exit(1);
+        }
+      }
+      _exit(0);
+    }
+    ASSERT_NOT_EQ(pids[i], -1);
+  }
+  int failed = 0;
+  for (int i = 0; i < TEST_PROCESS_COUNT; i++) {
+    int wstatus;
+    waitpid(pids[i], &wstatus, 0);
+    failed |= !WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0;
+  }
+  ASSERT_EQ(failed, 0);
+
+  // no transition is lost
+  csm_state_t state;
+  uint32_t sequence;
+  ret = csm_shm_machine_load(&store, 0, &state, CSM_NULL, &sequence);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(sequence, 1 + TEST_PROCESS_COUNT * TEST_TRANSIT_PER_PROCESS);
+  ASSERT_EQ(state, (TEST_PROCESS_COUNT * TEST_TRANSIT_PER_PROCESS) % TEST_RING_SIZE);
+  munmap(base, size);
+  return 0;
+}
+
+int test_shm_store_open_ok() {
+  csm_state_machine_t definition;
+  ASSERT_EQ(setup_definition(&definition), 0);
+
+  char name[64];
+  snprintf(name, sizeof(name), "/csm_shm_store_test_%d", (int)getpid());
+  csm_shm_store_t writer;
+  csm_machine_err_t ret = csm_shm_store_open(&writer, name, &definition, 4);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  csm_shm_store_t reader;
+  ret = csm_shm_store_open(&reader, name, CSM_NULL, 0);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  csm_shm_machine_start(&writer, 3);
+  csm_shm_machine_transit(&writer, 3, TEST_TRANSITION_NEXT, CSM_NULL, CSM_NULL);
+
+  csm_state_t state;
+  ret = csm_shm_machine_load(&reader, 3, &state, CSM_NULL, CSM_NULL);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(state, 1);
+
+  csm_shm_store_close(&reader);
+  csm_shm_store_close(&writer);
+  ret = csm_shm_store_unlink(name);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  return 0;
+}
+
+int test_shm_store_recover_unformatted_ok() {
+  csm_state_machine_t definition;
+  ASSERT_EQ(setup_definition(&definition), 0);
+
+  // creator died right after creating the object
+  char name[64];
+  snprintf(name, sizeof(name), "/csm_shm_store_test_crash_%d", (int)getpid());
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  ASSERT_NOT_EQ(fd, -1);
+  ASSERT_EQ(ftruncate(fd, (off_t)csm_shm_store_size(4)), 0);
+  close(fd);
+
+  csm_shm_store_t store;
+  csm_machine_err_t ret = csm_shm_store_open(&store, name, CSM_NULL, 0);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_FAILED);
+  ret = csm_shm_store_open(&store, name, &definition, 4);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_FAILED);
+
+  ret = csm_shm_store_unlink(name);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ret = csm_shm_store_open(&store, name, &definition, 4);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  csm_shm_store_close(&store);
+  ret = csm_shm_store_unlink(name);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  return 0;
+}
+
+int main() {
+  int ret = 0;
+  ret |= test_shm_store_transit_ok();
+  ret |= test_shm_store_attach_should_failed_if_not_formatted();
+  ret |= test_shm_store_attach_should_failed_if_tables_out_of_segment();
+  ret |= test_shm_store_multi_process_transit_ok();
+  ret |= test_shm_store_open_ok();
+  ret |= test_shm_store_recover_unformatted_ok();
+  return ret;
+}
@@ -0,0 +1,140 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "assert.h"
+#include "state_machine.h"
+
+#define TEST_RING_SIZE (7)
+#define TEST_THREAD_COUNT (4)
+#define TEST_TRANSIT_PER_THREAD (10000)
+
+typedef enum {
+  TEST_TRANSITION_NEXT,
+} test_transition;
+
+static csm_state_transition_node_t trans_nodes[TEST_RING_SIZE];
+static atomic_int callback_count;
+static atomic_int callback_mismatch;
+
+static void on_state_changed(csm_state_machine_t *machine, csm_state_t prev_state, csm_state_t new_state) {
+  atomic_fetch_add(&callback_count, 1);
+  if ((prev_state + 1) % TEST_RING_SIZE != new_state) {
+    atomic_fetch_add(&callback_mismatch, 1);
+  }
+}
+
+static void *transit_worker(void *arg) {
+  csm_state_machine_t *machine = (csm_state_machine_t *)arg;
+  for (int i = 0; i < TEST_TRANSIT_PER_THREAD; i++) {
+    csm_machine_transit(machine, TEST_TRANSITION_NEXT);
+  }
+  return CSM_NULL;
+}
+
+int test_state_machine_concurrent_transit_ok() {
+  csm_state_machine_t machine;
+  csm_machine_err_t ret = csm_machine_initialize(&machine, 0);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  for (int i = 0; i < TEST_RING_SIZE; i++) {
+    trans_nodes[i].from_state = i;
+    trans_nodes[i].transition = TEST_TRANSITION_NEXT;
+    trans_nodes[i].to_state = (i + 1) % TEST_RING_SIZE;
+    ret = csm_machine_define_state_transition(&machine, &trans_nodes[i]);
+    ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  }
+  csm_machine_register_on_state_changed(&machine, on_state_changed);
+  ret = csm_machine_start(&machine);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  pthread_t threads[TEST_THREAD_COUNT];
+  for (int i = 0; i < TEST_THREAD_COUNT; i++) {
+    ASSERT_EQ(pthread_create(&threads[i], CSM_NULL, transit_worker, &machine), 0);
+  }
+  for (int i = 0; i < TEST_THREAD_COUNT; i++) {
+    pthread_join(threads[i], CSM_NULL);
+  }
+
+  // every transit is applied exactly once, with the state pair it was applied to
+  ASSERT_EQ(atomic_load(&callback_count), TEST_THREAD_COUNT * TEST_TRANSIT_PER_THREAD);
+  ASSERT_EQ(atomic_load(&callback_mismatch), 0);
+  ASSERT_EQ(csm_machine_get_current_state(&machine), (TEST_THREAD_COUNT * TEST_TRANSIT_PER_THREAD) % TEST_RING_SIZE);
+
+  ret = csm_machine_stop(&machine);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ret = csm_machine_transit(&machine, TEST_TRANSITION_NEXT);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_ILLEGAL_STATUS);
+  ret = csm_machine_reset(&machine);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_machine_get_current_state(&machine), 0);
+  ASSERT_EQ(csm_machine_get_status(&machine), CSM_MACHINE_STATUS_STARTED);
+  return 0;
+}
+
+#if CSM_FLIGHT_RECORDER_DEPTH > 0
+int test_state_machine_concurrent_flight_records_ok() {
+  csm_state_machine_t machine;
+  csm_machine_initialize(&machine, 0);
+  for (int i = 0; i < TEST_RING_SIZE; i++) {
+    csm_machine_define_state_transition(&machine, &trans_nodes[i]);
+  }
+  csm_machine_start(&machine);
+
+  pthread_t threads[TEST_THREAD_COUNT];
+  for (int i = 0; i < TEST_THREAD_COUNT; i++) {
+    ASSERT_EQ(pthread_create(&threads[i], CSM_NULL, transit_worker, &machine), 0);
+  }
+  // read the records while they are being written, none of them may be torn
+  int mismatch = 0;
+  csm_flight_record_t records[CSM_FLIGHT_RECORDER_DEPTH];
+  int count;
+  for (int round = 0; round < 1000; round++) {
+    csm_machine_flight_records(&machine, records, CSM_FLIGHT_RECORDER_DEPTH, &count);
+    for (int i = 0; i < count; i++) {
+      if ((records[i].prev_state + 1) % TEST_RING_SIZE != records[i].new_state ||
+          records[i].transition != TEST_TRANSITION_NEXT || records[i].result != CSM_MACHINE_ERR_OK) {
+        mismatch++;
+      }
+    }
+  }
+  for (int i = 0; i < TEST_THREAD_COUNT; i++) {
+    pthread_join(threads[i], CSM_NULL);
+  }
+  ASSERT_EQ(mismatch, 0);
+
+  csm_machine_flight_records(&machine, records, CSM_FLIGHT_RECORDER_DEPTH, &count);
+  ASSERT_EQ(count > 0, 1);
+  return 0;
+}
+#endif
+
+int main() {
+  int ret = 0;
+  ret |= test_state_machine_concurrent_transit_ok();
+#if CSM_FLIGHT_RECORDER_DEPTH > 0
+  ret |= test_state_machine_concurrent_flight_records_ok();
+#endif
+  return ret;
+}
@@ -0,0 +1,176 @@
+/*
+ *  The MIT License (MIT)
+ * Copyright (c) 2024 Enix Yu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "state_machine_path.h"
+
+#include "assert.h"
+
+typedef enum {
+  TEST_STATE_0,
+  TEST_STATE_1,
+  TEST_STATE_2,
+  TEST_STATE_3,
+  TEST_STATE_4,
+} test_state;
+
+typedef enum {
+  TEST_TRANSITION_A,
+  TEST_TRANSITION_B,
+  TEST_TRANSITION_C,
+} test_transition;
+
+// 0 --A--> 1 --B--> 2 --C--> 3
+// 0 --C--> 2
+// 3 --A--> 0
+// 4 is isolated
+static csm_state_transition_node_t trans_nodes[] = {
+    {.from_state = TEST_STATE_0, .transition = TEST_TRANSITION_A, .to_state = TEST_STATE_1},
+    {.from_state = TEST_STATE_1, .transition = TEST_TRANSITION_B, .to_state = TEST_STATE_2},
+    {.from_state = TEST_STATE_2, .transition = TEST_TRANSITION_C, .to_state = TEST_STATE_3},
+    {.from_state = TEST_STATE_0, .transition = TEST_TRANSITION_C, .to_state = TEST_STATE_2},
+    {.from_state = TEST_STATE_3, .transition = TEST_TRANSITION_A, .to_state = TEST_STATE_0},
+};
+
+static int setup_machine(csm_state_machine_t *machine, csm_state_t init_state) {
+  csm_machine_err_t ret = csm_machine_initialize(machine, init_state);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  for (int i = 0; i < (int)(sizeof(trans_nodes) / sizeof(trans_nodes[0])); i++) {
+    ret = csm_machine_define_state_transition(machine, &trans_nodes[i]);
+    ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  }
+  return 0;
+}
+
+int test_path_index_reachable_ok() {
+  csm_state_machine_t machine;
+  ASSERT_EQ(setup_machine(&machine, TEST_STATE_0), 0);
+
+  csm_path_index_t index;
+  csm_machine_err_t ret = csm_path_index_build(&index, &machine);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  ASSERT_EQ(csm_path_index_is_reachable(&index, TEST_STATE_0, TEST_STATE_0), CSM_TRUE);
+  ASSERT_EQ(csm_path_index_is_reachable(&index, TEST_STATE_0, TEST_STATE_3), CSM_TRUE);
+  ASSERT_EQ(csm_path_index_is_reachable(&index, TEST_STATE_2, TEST_STATE_1), CSM_TRUE);
+  ASSERT_EQ(csm_path_index_is_reachable(&index, TEST_STATE_0, TEST_STATE_4), CSM_FALSE);
+  ASSERT_EQ(csm_path_index_is_reachable(&index, TEST_STATE_4, TEST_STATE_0), CSM_FALSE);
+  ASSERT_EQ(csm_path_index_is_reachable(&index, TEST_STATE_4, TEST_STATE_4), CSM_TRUE);
+  ASSERT_EQ(csm_path_index_is_reachable(&index, TEST_STATE_0, CSM_STATE_COUNT), CSM_FALSE);
+  return 0;
+}
+
+int test_machine_path_to_ok() {
+  csm_state_machine_t machine;
+  ASSERT_EQ(setup_machine(&machine, TEST_STATE_1), 0);
+
+  csm_path_index_t index;
+  csm_machine_err_t ret = csm_path_index_build(&index, &machine);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  csm_transition_t transitions[8];
+  int length;
+  ret = csm_machine_path_to(&machine, &index, TEST_STATE_3, transitions, 8, &length);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_ILLEGAL_STATUS);
+
+  ret = csm_machine_start(&machine);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  // 1 --B--> 2 --C--> 3 --A--> 0 --C--> 2, shortest is B, C, A
+  ret = csm_machine_path_to(&machine, &index, TEST_STATE_0, transitions, 8, &length);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(length, 3);
+  ASSERT_EQ(transitions[0], TEST_TRANSITION_B);
+  ASSERT_EQ(transitions[1], TEST_TRANSITION_C);
+  ASSERT_EQ(transitions[2], TEST_TRANSITION_A);
+
+  // replaying the path drives the machine to the target
+  for (int i = 0; i < length; i++) {
+    ret = csm_machine_transit(&machine, transitions[i]);
+    ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  }
+  ASSERT_EQ(machine.current_state, TEST_STATE_0);
+
+  // shortcut 0 --C--> 2 is preferred over 0 --A--> 1 --B--> 2
+  ret = csm_machine_path_to(&machine, &index, TEST_STATE_2, transitions, 8, &length);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(length, 1);
+  ASSERT_EQ(transitions[0], TEST_TRANSITION_C);
+
+  ret = csm_machine_path_to(&machine, &index, TEST_STATE_0, transitions, 8, &length);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(length, 0);
+
+  ret = csm_machine_path_to(&machine, &index, TEST_STATE_4, transitions, 8, &length);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_ILLEGAL_TRANSITION);
+  return 0;
+}
+
+// 0 --A--> 1 --B--> 2, the later 0 --A--> 2 and 0 --A--> 3 are shadowed by the first definition
+static csm_state_transition_node_t shadowed_nodes[] = {
+    {.from_state = TEST_STATE_0, .transition = TEST_TRANSITION_A, .to_state = TEST_STATE_1},
+    {.from_state = TEST_STATE_0, .transition = TEST_TRANSITION_A, .to_state = TEST_STATE_2},
+    {.from_state = TEST_STATE_1, .transition = TEST_TRANSITION_B, .to_state = TEST_STATE_2},
+    {.from_state = TEST_STATE_0, .transition = TEST_TRANSITION_A, .to_state = TEST_STATE_3},
+};
+
+int test_machine_path_to_skip_shadowed_transition_ok() {
+  csm_state_machine_t machine;
+  csm_machine_err_t ret = csm_machine_initialize(&machine, TEST_STATE_0);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  for (int i = 0; i < (int)(sizeof(shadowed_nodes) / sizeof(shadowed_nodes[0])); i++) {
+    ret = csm_machine_define_state_transition(&machine, &shadowed_nodes[i]);
+    ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  }
+  csm_path_index_t index;
+  ret = csm_path_index_build(&index, &machine);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(csm_path_index_is_reachable(&index, TEST_STATE_0, TEST_STATE_2), CSM_TRUE);
+  ASSERT_EQ(csm_path_index_is_reachable(&index, TEST_STATE_0, TEST_STATE_3), CSM_FALSE);
+
+  ret = csm_machine_start(&machine);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  csm_transition_t transitions[8];
+  int length;
+  ret = csm_machine_path_to(&machine, &index, TEST_STATE_2, transitions, 8, &length);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(length, 2);
+
+  // replaying the path drives the machine to the target
+  for (int i = 0; i < length; i++) {
+    ret = csm_machine_transit(&machine, transitions[i]);
+    ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  }
+  ASSERT_EQ(machine.current_state, TEST_STATE_2);
+
+  ret = csm_machine_path_to(&machine, &index, TEST_STATE_3, transitions, 8, &length);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_ILLEGAL_TRANSITION);
+  return 0;
+}
+
+int main() {
+  int ret = 0;
+  ret |= test_path_index_reachable_ok();
+  ret |= test_machine_path_to_ok();
+  ret |= test_machine_path_to_skip_shadowed_transition_ok();
+  return ret;
+}
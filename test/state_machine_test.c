@@ -23,6 +23,8 @@
 
 #include "state_machine.h"
 
+#include <stddef.h>
+
 #include "assert.h"
 
 typedef enum {
@@ -128,11 +130,319 @@ int test_state_machine_should_transit_ok() {
   return 0;
 }
 
+int test_state_machine_available_transitions_ok() {
+  csm_state_machine_t machine;
+  csm_machine_err_t ret = csm_machine_initialize(&machine, TEST_STATE_0);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  csm_state_transition_node_t trans_node1 = {
+      .from_state = TEST_STATE_0,
+      .transition = TEST_TRANSITION_A,
+      .to_state = TEST_STATE_1,
+  };
+  ret = csm_machine_define_state_transition(&machine, &trans_node1);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  csm_state_transition_node_t trans_node2 = {
+      .from_state = TEST_STATE_0,
+      .transition = TEST_TRANSITION_C,
+      .to_state = TEST_STATE_2,
+  };
+  ret = csm_machine_define_state_transition(&machine, &trans_node2);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  csm_state_transition_node_t trans_node3 = {
+      .from_state = TEST_STATE_0,
+      .transition = CSM_TRANSITION_COUNT,
+      .to_state = TEST_STATE_2,
+  };
+  ret = csm_machine_define_state_transition(&machine, &trans_node3);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_FAILED);
+
+  csm_state_transition_node_t trans_node4 = {
+      .from_state = TEST_STATE_0,
+      .transition = TEST_TRANSITION_C,
+      .to_state = CSM_STATE_COUNT,
+  };
+  ret = csm_machine_define_state_transition(&machine, &trans_node4);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_FAILED);
+
+  // not started yet
+  ASSERT_EQ(csm_machine_can_transit(&machine, TEST_TRANSITION_A), CSM_FALSE);
+  csm_transition_t transitions[4];
+  int count;
+  ret = csm_machine_available_transitions(&machine, transitions, 4, &count);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_ILLEGAL_STATUS);
+
+  ret = csm_machine_start(&machine);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  ASSERT_EQ(csm_machine_can_transit(&machine, TEST_TRANSITION_A), CSM_TRUE);
+  ASSERT_EQ(csm_machine_can_transit(&machine, TEST_TRANSITION_B), CSM_FALSE);
+  ASSERT_EQ(csm_machine_can_transit(&machine, TEST_TRANSITION_C), CSM_TRUE);
+  ASSERT_EQ(csm_machine_can_transit(&machine, -1), CSM_FALSE);
+  ASSERT_EQ(machine.current_state, TEST_STATE_0);
+
+  ret = csm_machine_available_transitions(&machine, transitions, 4, &count);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(count, 2);
+  ASSERT_EQ(transitions[0], TEST_TRANSITION_A);
+  ASSERT_EQ(transitions[1], TEST_TRANSITION_C);
+
+  ret = csm_machine_transit(&machine, TEST_TRANSITION_B);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_ILLEGAL_TRANSITION);
+  ret = csm_machine_transit(&machine, TEST_TRANSITION_A);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  ret = csm_machine_available_transitions(&machine, transitions, 4, &count);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(count, 0);
+  return 0;
+}
+
+int test_state_machine_can_transit_bulk_ok() {
+  csm_state_machine_t machine1;
+  csm_state_machine_t machine2;
+  csm_state_machine_t machine3;
+  csm_machine_initialize(&machine1, TEST_STATE_0);
+  csm_machine_initialize(&machine2, TEST_STATE_1);
+  csm_machine_initialize(&machine3, TEST_STATE_0);
+
+  csm_state_transition_node_t trans_node = {
+      .from_state = TEST_STATE_0,
+      .transition = TEST_TRANSITION_B,
+      .to_state = TEST_STATE_1,
+  };
+  csm_machine_define_state_transition(&machine1, &trans_node);
+  csm_machine_define_state_transition(&machine2, &trans_node);
+  csm_machine_define_state_transition(&machine3, &trans_node);
+  csm_machine_start(&machine1);
+  csm_machine_start(&machine2);
+
+  csm_state_machine_t *machines[] = {&machine1, &machine2, &machine3};
+  csm_bool results[3];
+  csm_machine_err_t ret = csm_machine_can_transit_bulk(machines, 3, TEST_TRANSITION_B, results);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(results[0], CSM_TRUE);
+  ASSERT_EQ(results[1], CSM_FALSE);
+  ASSERT_EQ(results[2], CSM_FALSE);
+  return 0;
+}
+
+int test_state_machine_dealloc_should_return_nodes_to_pool() {
+  csm_state_transition_node_t trans_node = {
+      .from_state = TEST_STATE_0,
+      .transition = TEST_TRANSITION_A,
+      .to_state = TEST_STATE_1,
+  };
+  // each round takes half of the pool, which only fits if the previous rounds gave their nodes back
+  for (int round = 0; round < 4; round++) {
+    csm_state_machine_t machine;
+    csm_machine_initialize(&machine, TEST_STATE_0);
+    for (int i = 0; i < CONFIG_NODE_POOL_SIZE / 2; i++) {
+      csm_machine_err_t ret = csm_machine_define_state_transition(&machine, &trans_node);
+      ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+    }
+    csm_machine_start(&machine);
+    csm_machine_stop(&machine);
+    csm_machine_err_t ret = csm_machine_dealloc(&machine);
+    ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+    ASSERT_EQ(machine.internal_machine_status, CSM_MACHINE_STATUS_DESTROYED);
+  }
+  return 0;
+}
+
+int test_state_machine_with_arena_allocator_ok() {
+  max_align_t buffer[64];
+  csm_arena_t arena;
+  csm_arena_initialize(&arena, buffer, sizeof(buffer));
+  csm_allocator_t allocator;
+  csm_arena_allocator(&arena, &allocator);
+
+  csm_state_machine_t machine;
+  csm_machine_err_t ret = csm_machine_initialize_with_allocator(&machine, TEST_STATE_0, &allocator);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+
+  // the transition is copied into the arena, the caller storage can be reused
+  csm_state_transition_node_t trans_node = {
+      .from_state = TEST_STATE_0,
+      .transition = TEST_TRANSITION_A,
+      .to_state = TEST_STATE_1,
+  };
+  ret = csm_machine_define_state_transition(&machine, &trans_node);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  trans_node.from_state = TEST_STATE_1;
+  trans_node.transition = TEST_TRANSITION_B;
+  trans_node.to_state = TEST_STATE_2;
+  ret = csm_machine_define_state_transition(&machine, &trans_node);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_NOT_EQ(arena.offset, 0);
+
+  csm_machine_start(&machine);
+  ret = csm_machine_transit(&machine, TEST_TRANSITION_A);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ret = csm_machine_transit(&machine, TEST_TRANSITION_B);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(machine.current_state, TEST_STATE_2);
+
+  csm_machine_stop(&machine);
+  ret = csm_machine_dealloc(&machine);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(arena.offset, 0);
+  return 0;
+}
+
+int test_state_machine_define_should_failed_when_arena_full() {
+  // too small for a list node and a transition
+  max_align_t buffer[1];
+  csm_arena_t arena;
+  csm_arena_initialize(&arena, buffer, sizeof(csm_linked_list_node_t));
+  csm_allocator_t allocator;
+  csm_arena_allocator(&arena, &allocator);
+
+  csm_state_machine_t machine;
+  csm_machine_initialize_with_allocator(&machine, TEST_STATE_0, &allocator);
+  csm_state_transition_node_t trans_node = {
+      .from_state = TEST_STATE_0,
+      .transition = TEST_TRANSITION_A,
+      .to_state = TEST_STATE_1,
+  };
+  csm_machine_err_t ret = csm_machine_define_state_transition(&machine, &trans_node);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_FAILED);
+  ASSERT_EQ(machine.state_transition_linked_list[TEST_STATE_0].head, CSM_NULL);
+  return 0;
+}
+
+int test_state_machine_adaptive_transition_order_ok() {
+  csm_state_machine_t machine;
+  csm_machine_initialize(&machine, TEST_STATE_0);
+  csm_state_transition_node_t trans_node1 = {
+      .from_state = TEST_STATE_0,
+      .transition = TEST_TRANSITION_A,
+      .to_state = TEST_STATE_1,
+  };
+  csm_state_transition_node_t trans_node2 = {
+      .from_state = TEST_STATE_0,
+      .transition = TEST_TRANSITION_B,
+      .to_state = TEST_STATE_0,
+  };
+  csm_state_transition_node_t trans_node3 = {
+      .from_state = TEST_STATE_1,
+      .transition = TEST_TRANSITION_C,
+      .to_state = TEST_STATE_0,
+  };
+  csm_machine_define_state_transition(&machine, &trans_node1);
+  csm_machine_define_state_transition(&machine, &trans_node2);
+  csm_machine_define_state_transition(&machine, &trans_node3);
+  csm_machine_err_t ret = csm_machine_set_adaptive_transition_order(&machine, CSM_TRUE);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  csm_machine_start(&machine);
+
+  csm_linked_list_t *linked_list = &machine.state_transition_linked_list[TEST_STATE_0];
+  ASSERT_EQ(linked_list->head->data, &trans_node1);
+  ret = csm_machine_transit(&machine, TEST_TRANSITION_B);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(linked_list->head->data, &trans_node2);
+  ASSERT_EQ(linked_list->head->next->data, &trans_node1);
+
+  ret = csm_machine_transit(&machine, TEST_TRANSITION_A);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(machine.current_state, TEST_STATE_1);
+  ASSERT_EQ(linked_list->head->data, &trans_node1);
+  return 0;
+}
+
+static int illegal_transition_count = 0;
+static csm_flight_record_t dumped_records[CSM_FLIGHT_RECORDER_DEPTH];
+static int dumped_count = 0;
+
+static void on_illegal_transition(csm_state_machine_t *machine, csm_state_t state, csm_transition_t transition) {
+  illegal_transition_count++;
+  csm_machine_flight_records(machine, dumped_records, CSM_FLIGHT_RECORDER_DEPTH, &dumped_count);
+}
+
+int test_state_machine_flight_recorder_ok() {
+  csm_state_machine_t machine;
+  csm_machine_initialize(&machine, TEST_STATE_0);
+  csm_state_transition_node_t trans_node1 = {
+      .from_state = TEST_STATE_0,
+      .transition = TEST_TRANSITION_A,
+      .to_state = TEST_STATE_1,
+  };
+  csm_state_transition_node_t trans_node2 = {
+      .from_state = TEST_STATE_1,
+      .transition = TEST_TRANSITION_B,
+      .to_state = TEST_STATE_0,
+  };
+  csm_machine_define_state_transition(&machine, &trans_node1);
+  csm_machine_define_state_transition(&machine, &trans_node2);
+  csm_machine_register_on_illegal_transition(&machine, on_illegal_transition);
+  csm_machine_start(&machine);
+
+  csm_flight_record_t records[CSM_FLIGHT_RECORDER_DEPTH];
+  int count;
+  csm_machine_err_t ret = csm_machine_flight_records(&machine, records, CSM_FLIGHT_RECORDER_DEPTH, &count);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(count, 0);
+
+  csm_machine_transit(&machine, TEST_TRANSITION_A);
+  ret = csm_machine_transit(&machine, TEST_TRANSITION_C);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_ILLEGAL_TRANSITION);
+
+  // the illegal transition is recorded before the callback dumps the records
+  ASSERT_EQ(illegal_transition_count, 1);
+  ASSERT_EQ(dumped_count, 2);
+  ASSERT_EQ(dumped_records[0].prev_state, TEST_STATE_0);
+  ASSERT_EQ(dumped_records[0].transition, TEST_TRANSITION_A);
+  ASSERT_EQ(dumped_records[0].new_state, TEST_STATE_1);
+  ASSERT_EQ(dumped_records[0].result, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(dumped_records[1].prev_state, TEST_STATE_1);
+  ASSERT_EQ(dumped_records[1].transition, TEST_TRANSITION_C);
+  ASSERT_EQ(dumped_records[1].new_state, TEST_STATE_1);
+  ASSERT_EQ(dumped_records[1].result, CSM_MACHINE_ERR_ILLEGAL_TRANSITION);
+
+  // wrap around, only the most recent records are kept, oldest first
+  for (int i = 0; i < CSM_FLIGHT_RECORDER_DEPTH; i++) {
+    csm_machine_transit(&machine, i % 2 == 0 ? TEST_TRANSITION_B : TEST_TRANSITION_A);
+  }
+  ret = csm_machine_flight_records(&machine, records, CSM_FLIGHT_RECORDER_DEPTH, &count);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(count, CSM_FLIGHT_RECORDER_DEPTH);
+  ASSERT_EQ(records[0].transition, TEST_TRANSITION_B);
+  ASSERT_EQ(records[CSM_FLIGHT_RECORDER_DEPTH - 1].transition, TEST_TRANSITION_A);
+  ASSERT_EQ(records[CSM_FLIGHT_RECORDER_DEPTH - 1].new_state, TEST_STATE_1);
+#if CONFIG_FLIGHT_RECORDER_TIMESTAMP && (defined(__x86_64__) || defined(__aarch64__))
+  // cycle counter stamps, statemachine_flight_recorder_timestamp_test only
+  for (int i = 0; i < CSM_FLIGHT_RECORDER_DEPTH; i++) {
+    ASSERT_NOT_EQ(records[i].timestamp, 0);
+    if (i > 0) {
+      ASSERT_EQ(records[i - 1].timestamp <= records[i].timestamp, 1);
+    }
+  }
+#else
+  ASSERT_EQ(records[0].timestamp, 0);
+#endif
+
+  // capacity smaller than the recorder keeps the most recent ones
+  ret = csm_machine_flight_records(&machine, records, 1, &count);
+  ASSERT_EQ(ret, CSM_MACHINE_ERR_OK);
+  ASSERT_EQ(count, 1);
+  ASSERT_EQ(records[0].transition, TEST_TRANSITION_A);
+  return 0;
+}
+
 int main() {
   int ret = 0;
   ret |= test_state_machine_init_ok();
   ret |= test_state_machine_start_ok();
   ret |= test_state_machine_should_transit_ok();
   ret |= test_state_machine_stop_should_failed_if_machine_not_started();
+  ret |= test_state_machine_available_transitions_ok();
+  ret |= test_state_machine_can_transit_bulk_ok();
+  ret |= test_state_machine_dealloc_should_return_nodes_to_pool();
+  ret |= test_state_machine_with_arena_allocator_ok();
+  ret |= test_state_machine_define_should_failed_when_arena_full();
+  ret |= test_state_machine_adaptive_transition_order_ok();
+  ret |= test_state_machine_flight_recorder_ok();
   return ret;
 }